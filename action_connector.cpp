@@ -25,6 +25,8 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include <cassert>              // assert
 
+#include "size_helper.h"        // SizeHelper
+
 namespace fsm {
 
 ActionConnector::ActionConnector( uint32_t log_id, element_id_t id, Action * action ):
@@ -106,4 +108,19 @@ const Action* ActionConnector::get_action() const
     return action_.get();
 }
 
+Action* ActionConnector::get_action()
+{
+    return action_.get();
+}
+
+std::size_t ActionConnector::get_memory_usage() const
+{
+    std::size_t res = sizeof( * this ) + switch_actions_.capacity() * sizeof( element_id_t );
+
+    if( action_ )
+        res += SizeHelper::get_size( * action_ );
+
+    return res;
+}
+
 } // namespace fsm
@@ -51,6 +51,9 @@ public:
     const std::vector<element_id_t> & get_switch_actions() const;
 
     const Action* get_action() const;
+    Action* get_action();
+
+    std::size_t get_memory_usage() const;
 
 private:
     ActionConnector( const ActionConnector & )              = delete;
@@ -19,49 +19,112 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-// $Revision: 10379 $ $Date:: 2019-01-04 #$ $Author: serge $
+// $Revision: 11664 $ $Date:: 2019-06-19 #$ $Author: serge $
 
 #ifndef LIB_FSM__ACTIONS_H
 #define LIB_FSM__ACTIONS_H
 
 #include <vector>               // std::vector
+#include <memory>               // std::unique_ptr
+#include <unordered_map>        // std::unordered_map
 
 #include "expression.h"         // Expression, Action
 
 namespace fsm {
 
+class Timer;
+class Variable;
+
+// argument list precomputed by Process::finalize(), only the variable slots are evaluated on each execution
+struct ArgumentCache
+{
+    std::vector<Value>      values;
+    std::vector<unsigned>   variable_slots;
+};
+
+typedef std::unique_ptr<ArgumentCache> ArgumentCachePtr;
+
+// case numbers of a switch whose case values are constants of one type, built by Process::finalize()
+struct SwitchTable
+{
+    data_type_e                             type;
+
+    std::unordered_map<int64_t,int>         map_int_to_case;        // BOOL and INT
+    std::unordered_map<double,int>          map_double_to_case;
+    std::unordered_map<std::string,int>     map_string_to_case;
+};
+
+typedef std::unique_ptr<SwitchTable> SwitchTablePtr;
+
 struct SendSignal: public Action
 {
+    enum class target_e
+    {
+        ENV,            // ICallback::handle_send_signal()
+        PROCESS,        // process id given by the expression 'to'
+        SELF,
+        PARENT          // see FsmManager::create_process()
+    };
+
     SendSignal( const std::string & name, const std::vector<ExpressionPtr> & arguments ):
+        target( target_e::ENV ),
+        name( name ),
+        arguments( arguments )
+    {
+    }
+
+    // SELF or PARENT
+    SendSignal( target_e target, const std::string & name, const std::vector<ExpressionPtr> & arguments ):
+        target( target ),
+        name( name ),
+        arguments( arguments )
+    {
+    }
+
+    SendSignal( const ExpressionPtr & to, const std::string & name, const std::vector<ExpressionPtr> & arguments ):
+        target( target_e::PROCESS ),
+        to( to ),
         name( name ),
         arguments( arguments )
     {
     }
 
+    target_e                    target;
+    ExpressionPtr               to;
     std::string                 name;
     std::vector<ExpressionPtr>  arguments;
+
+    ArgumentCachePtr            cache;
 };
 
 struct SetTimer: public Action
 {
     SetTimer( element_id_t timer_id, const ExpressionPtr & delay ):
         timer_id( timer_id ),
-        delay( delay )
+        delay( delay ),
+        timer( nullptr )
     {
     }
 
     element_id_t            timer_id;
     ExpressionPtr           delay;
+
+    // resolved by the validation in Process::finalize()
+    Timer                   * timer;
 };
 
 struct ResetTimer: public Action
 {
     ResetTimer( element_id_t timer_id ):
-        timer_id( timer_id )
+        timer_id( timer_id ),
+        timer( nullptr )
     {
     }
 
     element_id_t            timer_id;
+
+    // resolved by the validation in Process::finalize()
+    Timer                   * timer;
 };
 
 struct FunctionCall: public Action
@@ -74,18 +137,24 @@ struct FunctionCall: public Action
 
     std::string                                 name;
     std::vector<std::pair<bool,ExpressionPtr>>  arguments;
+
+    ArgumentCachePtr                            cache;
 };
 
 struct Task: public Action
 {
     Task( element_id_t variable_id, const ExpressionPtr & expr ):
         variable_id( variable_id ),
-        expr( expr )
+        expr( expr ),
+        variable( nullptr )
     {
     }
 
     element_id_t            variable_id;
     ExpressionPtr           expr;
+
+    // resolved by the validation in Process::finalize()
+    Variable                * variable;
 };
 
 struct Condition: public Action
@@ -96,13 +165,20 @@ struct Condition: public Action
             ExpressionPtr               rhs ):
         type( type ),
         lhs( lhs ),
-        rhs( rhs )
+        rhs( rhs ),
+        operand_type( data_type_e::UNDEF ),
+        comparison( nullptr )
     {
     }
 
     comparison_type_e           type;
     ExpressionPtr               lhs;
     ExpressionPtr               rhs;
+
+    // set by the type check in Process::finalize(), UNDEF - not known statically
+    data_type_e                 operand_type;
+    // selected by the type check, nullptr - anyvalue is used
+    TypedOperations::Comparison comparison;
 };
 
 struct SwitchCondition: public Action
@@ -117,6 +193,8 @@ struct SwitchCondition: public Action
 
     ExpressionPtr               var;
     std::vector<ExpressionPtr>  values;
+
+    SwitchTablePtr              table;
 };
 
 struct NextState: public Action
@@ -0,0 +1,251 @@
+/*
+
+FSM. Compact value.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11629 $ $Date:: 2019-06-01 #$ $Author: serge $
+
+#include "compact_value.h"      // self
+
+#include <cassert>              // assert
+#include <cstring>              // memcpy
+#include <new>                  // placement new
+
+namespace fsm {
+
+CompactValue::CompactValue()
+{
+    plain_.type     = uint8_t( data_type_e::UNDEF );
+    plain_.size     = 0;
+    plain_.arg_i    = 0;
+}
+
+CompactValue::CompactValue( const Value & v )
+{
+    plain_.type     = uint8_t( data_type_e::UNDEF );
+    plain_.size     = 0;
+
+    set( v );
+}
+
+CompactValue::CompactValue( const CompactValue & v )
+{
+    copy_from( v );
+}
+
+CompactValue::CompactValue( CompactValue && v )
+{
+    std::memcpy( & plain_, & v.plain_, sizeof( plain_ ) );
+
+    v.plain_.type   = uint8_t( data_type_e::UNDEF );
+    v.plain_.size   = 0;
+}
+
+CompactValue::~CompactValue()
+{
+    release();
+}
+
+CompactValue & CompactValue::operator=( const CompactValue & v )
+{
+    if( this != & v )
+    {
+        release();
+        copy_from( v );
+    }
+
+    return * this;
+}
+
+CompactValue & CompactValue::operator=( CompactValue && v )
+{
+    if( this != & v )
+    {
+        release();
+
+        std::memcpy( & plain_, & v.plain_, sizeof( plain_ ) );
+
+        v.plain_.type   = uint8_t( data_type_e::UNDEF );
+        v.plain_.size   = 0;
+    }
+
+    return * this;
+}
+
+void CompactValue::set( const Value & v )
+{
+    if( v.type == data_type_e::STRING && get_type() == data_type_e::STRING )
+    {
+        set_string( v.arg_s );
+        return;
+    }
+
+    release();
+
+    plain_.type     = uint8_t( v.type );
+    plain_.size     = 0;
+    plain_.arg_i    = 0;
+
+    switch( v.type )
+    {
+    case data_type_e::BOOL:
+        plain_.arg_b    = v.arg_b;
+        break;
+    case data_type_e::INT:
+        plain_.arg_i    = v.arg_i;
+        break;
+    case data_type_e::DOUBLE:
+        plain_.arg_d    = v.arg_d;
+        break;
+    case data_type_e::STRING:
+        init_string( v.arg_s );
+        break;
+    default:
+        break;
+    }
+}
+
+bool CompactValue::assign( const Value & v )
+{
+    if( v.type != get_type() )
+        return false;
+
+    set( v );
+
+    return true;
+}
+
+void CompactValue::get( Value * res ) const
+{
+    auto type = data_type_e( plain_.type );
+
+    res->type   = type;
+
+    switch( type )
+    {
+    case data_type_e::BOOL:
+        res->arg_b  = plain_.arg_b;
+        break;
+    case data_type_e::INT:
+        res->arg_i  = plain_.arg_i;
+        break;
+    case data_type_e::DOUBLE:
+        res->arg_d  = plain_.arg_d;
+        break;
+    case data_type_e::STRING:
+        // assign() reuses the storage of the target string
+        if( is_shared() )
+            res->arg_s.assign( plain_.shared->get_data(), plain_.shared->size );
+        else
+            res->arg_s.assign( inline_.data, inline_.size );
+        break;
+    default:
+        break;
+    }
+}
+
+data_type_e CompactValue::get_type() const
+{
+    return data_type_e( plain_.type );
+}
+
+bool CompactValue::is_same_buffer( const CompactValue & v ) const
+{
+    return is_shared() && v.is_shared() && plain_.shared == v.plain_.shared;
+}
+
+std::size_t CompactValue::get_heap_size() const
+{
+    if( is_shared() )
+        return sizeof( SharedString ) + plain_.shared->capacity;
+
+    return 0;
+}
+
+void CompactValue::init_string( const std::string & s )
+{
+    if( s.size() <= MAX_INLINE_SIZE )
+    {
+        inline_.size    = uint8_t( s.size() );
+
+        std::memcpy( inline_.data, s.data(), s.size() );
+
+        return;
+    }
+
+    auto buf = new char[ sizeof( SharedString ) + s.size() ];
+
+    auto shared = new( buf ) SharedString;
+
+    shared->ref_count   = 1;
+    shared->size        = uint32_t( s.size() );
+    shared->capacity    = uint32_t( s.size() );
+
+    std::memcpy( buf + sizeof( SharedString ), s.data(), s.size() );
+
+    plain_.size     = SHARED_SIZE;
+    plain_.shared   = shared;
+}
+
+void CompactValue::set_string( const std::string & s )
+{
+    // the buffer is owned by this value only, so nobody can read it concurrently
+    if( is_shared() && s.size() > MAX_INLINE_SIZE && s.size() <= plain_.shared->capacity && plain_.shared->ref_count == 1 )
+    {
+        std::memcpy( plain_.shared->get_data(), s.data(), s.size() );
+
+        plain_.shared->size = uint32_t( s.size() );
+
+        return;
+    }
+
+    release();
+
+    init_string( s );
+}
+
+void CompactValue::copy_from( const CompactValue & v )
+{
+    std::memcpy( & plain_, & v.plain_, sizeof( plain_ ) );
+
+    if( is_shared() )
+        ++plain_.shared->ref_count;
+}
+
+void CompactValue::release()
+{
+    if( is_shared() == false )
+        return;
+
+    if( --plain_.shared->ref_count == 0 )
+    {
+        plain_.shared->~SharedString();
+
+        delete[] reinterpret_cast<char*>( plain_.shared );
+    }
+
+    plain_.size = 0;
+}
+
+bool CompactValue::is_shared() const
+{
+    return plain_.type == uint8_t( data_type_e::STRING ) && plain_.size == SHARED_SIZE;
+}
+
+} // namespace fsm
@@ -0,0 +1,130 @@
+/*
+
+FSM. Compact value.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11629 $ $Date:: 2019-06-01 #$ $Author: serge $
+
+#ifndef LIB_FSM__COMPACT_VALUE_H
+#define LIB_FSM__COMPACT_VALUE_H
+
+#include <cstdint>              // uint8_t
+#include <cstddef>              // std::size_t
+#include <atomic>               // std::atomic
+
+#include "elements.h"           // Value
+
+namespace fsm {
+
+// 16-byte storage of Value: short strings are kept inline, long ones in an immutable buffer shared between copies
+class CompactValue
+{
+public:
+
+    static const unsigned MAX_INLINE_SIZE   = 14;
+
+    CompactValue();
+    explicit CompactValue( const Value & v );
+    CompactValue( const CompactValue & v );
+    CompactValue( CompactValue && v );
+    ~CompactValue();
+
+    CompactValue & operator=( const CompactValue & v );
+    CompactValue & operator=( CompactValue && v );
+
+    // a long string reuses the buffer if it is not shared with other copies and is large enough
+    void set( const Value & v );
+    // same as set(), but keeps the type, false - the value has a different type and is not assigned
+    bool assign( const Value & v );
+    void get( Value * res ) const;
+
+    data_type_e get_type() const;
+
+    // both values refer to the same shared buffer, e.g. strings interned in one StringPool, so they are equal,
+    // false doesn't mean that the values differ
+    bool is_same_buffer( const CompactValue & v ) const;
+
+    // heap allocated part, shared strings are counted at each reference
+    std::size_t get_heap_size() const;
+
+private:
+
+    struct SharedString
+    {
+        std::atomic<uint32_t>   ref_count;
+        uint32_t                size;
+        uint32_t                capacity;
+
+        const char * get_data() const
+        {
+            return reinterpret_cast<const char*>( this + 1 );
+        }
+
+        char * get_data()
+        {
+            return reinterpret_cast<char*>( this + 1 );
+        }
+    };
+
+    static const uint8_t SHARED_SIZE        = 0xFF;
+
+    struct Inline
+    {
+        uint8_t         type;
+        uint8_t         size;       // SHARED_SIZE - shared string
+        char            data[ MAX_INLINE_SIZE ];
+    };
+
+    struct Plain
+    {
+        uint8_t         type;
+        uint8_t         size;
+
+        union
+        {
+            bool            arg_b;
+            int64_t         arg_i;
+            double          arg_d;
+            SharedString    * shared;
+        };
+    };
+
+private:
+
+    void init_string( const std::string & s );
+    void set_string( const std::string & s );
+    void copy_from( const CompactValue & v );
+    void release();
+
+    bool is_shared() const;
+
+private:
+
+    union
+    {
+        Inline          inline_;
+        Plain           plain_;
+    };
+};
+
+static_assert( sizeof( CompactValue ) == 16, "CompactValue must be 16 bytes" );
+
+} // namespace fsm
+
+#endif // LIB_FSM__COMPACT_VALUE_H
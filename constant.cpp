@@ -26,6 +26,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include <cassert>              // assert
 
 #include "utils/dummy_logger.h"     // dummy_log_debug
+#include "size_helper.h"            // SizeHelper
 
 namespace fsm {
 
@@ -36,9 +37,23 @@ Constant::Constant( uint32_t log_id, element_id_t id, const std::string & name,
 {
     assert( id );
 
-    value_.type = type;
+    Value v;
 
-    assign( & value_, value );
+    v.type = type;
+
+    assign( & v, value );
+
+    value_.set( v );
+}
+
+Constant::Constant( uint32_t log_id, element_id_t id, const std::string & name, data_type_e type, const CompactValue & value ):
+        NamedElement( id, name ),
+        log_id_( log_id ),
+        type_( type ),
+        value_( value )
+{
+    assert( id );
+    assert( value.get_type() == type );
 }
 
 data_type_e Constant::get_type() const
@@ -46,9 +61,19 @@ data_type_e Constant::get_type() const
     return type_;
 }
 
-const Value & Constant::get() const
+void Constant::get( Value * value ) const
+{
+    value_.get( value );
+}
+
+const CompactValue & Constant::get_compact_value() const
 {
     return value_;
 }
 
+std::size_t Constant::get_memory_usage() const
+{
+    return sizeof( * this ) + SizeHelper::get_size( name_ ) + value_.get_heap_size();
+}
+
 } // namespace fsm
@@ -25,6 +25,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #define LIB_FSM__CONSTANT_H
 
 #include "elements.h"              // Value
+#include "compact_value.h"         // CompactValue
 
 namespace fsm {
 
@@ -32,9 +33,13 @@ class Constant: public NamedElement
 {
 public:
     Constant( uint32_t log_id, element_id_t id, const std::string & name, data_type_e type, const Value & value );
+    Constant( uint32_t log_id, element_id_t id, const std::string & name, data_type_e type, const CompactValue & value );
 
     data_type_e get_type() const;
-    const Value & get() const;
+    void get( Value * value ) const;
+    const CompactValue & get_compact_value() const;
+
+    std::size_t get_memory_usage() const;
 
 private:
     Constant( const Constant & )              = delete;
@@ -44,7 +49,7 @@ protected:
 
     uint32_t                                log_id_;
     data_type_e                             type_;
-    Value                                   value_;
+    CompactValue                            value_;
 };
 
 } // namespace fsm
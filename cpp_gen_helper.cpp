@@ -0,0 +1,862 @@
+/*
+
+FSM. C++ code generator.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11664 $ $Date:: 2019-06-19 #$ $Author: serge $
+
+#include "cpp_gen_helper.h"         // self
+
+#include <iomanip>                  // std::setprecision
+#include <sstream>                  // std::ostringstream
+#include <typeindex>                // std::type_index
+#include <typeinfo>
+#include <unordered_map>
+#include <map>
+#include <cmath>                    // std::isnan
+#include <cassert>
+
+#include "process.h"                // Process
+
+namespace fsm {
+
+#define TUPLE_VAL_STR(_x_)  _x_,#_x_
+
+CppGenHelper::CppGenHelper( const Process * l, const std::string & class_name ):
+        process_( l ),
+        class_name_( class_name )
+{
+}
+
+std::ostream & CppGenHelper::write( std::ostream & os )
+{
+    errors_.clear();
+
+    std::ostringstream body;
+
+    write_class_begin( body );
+    write_constructor( body );
+    write_states( body );
+    write_signal_handlers( body );
+    write_action_connectors( body );
+    write_variables( body );
+
+    body << "};\n";
+
+    os <<
+    "#include <string>               // std::string\n"
+    "#include <vector>               // std::vector\n"
+    "#include <limits>               // std::numeric_limits\n"
+    "\n"
+    "#include \"native_process.h\"     // fsm::NativeProcess\n"
+    "#include \"syntax_error.h\"       // fsm::SyntaxError\n"
+    "\n";
+
+    for( auto & e : errors_ )
+    {
+        os << "#error " << to_literal( e ) << "\n";
+    }
+
+    if( errors_.empty() == false )
+        os << "\n";
+
+    os << body.str();
+
+    return os;
+}
+
+void CppGenHelper::write_class_begin( std::ostream & os )
+{
+    os <<
+    "class " << class_name_ << ": public fsm::NativeProcess\n"
+    "{\n"
+    "public:\n"
+    "\n"
+    "    static fsm::NativeProcess* create( uint32_t id, uint32_t log_id, fsm::IFsm * parent, fsm::ICallback * callback, scheduler::IScheduler * scheduler )\n"
+    "    {\n"
+    "        return new " << class_name_ << "( id, log_id, parent, callback, scheduler );\n"
+    "    }\n"
+    "\n";
+}
+
+void CppGenHelper::write_constructor( std::ostream & os )
+{
+    os <<
+    "    " << class_name_ << "( uint32_t id, uint32_t log_id, fsm::IFsm * parent, fsm::ICallback * callback, scheduler::IScheduler * scheduler ):\n"
+    "            fsm::NativeProcess( id, log_id, parent, callback, scheduler ),\n"
+    "            state_( state_e::UNDEF )";
+
+    for( auto & e : process_->mem_.map_id_to_variable_ )
+    {
+        auto & v = * e.second;
+
+        os << ",\n            " << to_variable_name( v.get_id() ) << "(";
+
+        if( v.is_inited() )
+        {
+            Value value;
+
+            v.get( & value );
+
+            os << " " << convert( Code { to_literal( value ), value.type }, v.get_type() ) << " ";
+        }
+
+        os << ")";
+    }
+
+    os << "\n"
+    "    {\n";
+
+    for( auto & e : process_->map_id_to_timer_ )
+    {
+        os << "        add_timer( " << e.first << ", " << to_literal( e.second->get_name() ) << " );\n";
+    }
+
+    os <<
+    "    }\n"
+    "\n"
+    "    void start() override\n"
+    "    {\n";
+
+    if( process_->start_action_connector_ == 0 )
+    {
+        errors_.push_back( "start action connector is not set" );
+    }
+
+    os <<
+    "        execute( " << process_->start_action_connector_ << " );\n"
+    "    }\n"
+    "\n"
+    "private:\n"
+    "\n";
+}
+
+void CppGenHelper::write_states( std::ostream & os )
+{
+    os <<
+    "    enum class state_e\n"
+    "    {\n"
+    "        UNDEF,\n";
+
+    for( auto & e : process_->map_id_to_state_ )
+    {
+        os << "        " << to_state_name( e.first ) << ",     // " << e.second->get_name() << "\n";
+    }
+
+    os <<
+    "    };\n"
+    "\n";
+}
+
+void CppGenHelper::write_signal_handlers( std::ostream & os )
+{
+    os <<
+    "    bool handle_signal( const std::string & name ) override\n"
+    "    {\n"
+    "        switch( state_ )\n"
+    "        {\n";
+
+    for( auto & e : process_->map_id_to_state_ )
+    {
+        auto & state = * e.second;
+
+        os << "        case state_e::" << to_state_name( e.first ) << ":\n";
+
+        if( state.saved_signals_.empty() == false )
+        {
+            errors_.push_back( "saved signals are not supported, state " + state.get_name() );
+        }
+
+        for( auto & s : state.map_signal_name_to_signal_handler_ids_ )
+        {
+            auto it = process_->map_id_to_signal_handler_.find( s.second );
+
+            if( it == process_->map_id_to_signal_handler_.end() )
+            {
+                errors_.push_back( "cannot find signal handler " + std::to_string( s.second ) );
+                continue;
+            }
+
+            auto first_action_id = it->second->get_first_action_id();
+
+            os << "            if( name == " << to_literal( s.first ) << " )\n"
+                  "            {\n";
+
+            if( first_action_id )
+                os << "                execute( " << first_action_id << " );\n";
+
+            os << "                return true;\n"
+                  "            }\n";
+        }
+
+        os << "            return false;\n"
+              "\n";
+    }
+
+    os <<
+    "        default:\n"
+    "            return false;\n"
+    "        }\n"
+    "    }\n"
+    "\n";
+}
+
+void CppGenHelper::write_action_connectors( std::ostream & os )
+{
+    os <<
+    "    void execute( fsm::element_id_t action_connector_id )\n"
+    "    {\n"
+    "        for( ;; )\n"
+    "        {\n"
+    "            switch( action_connector_id )\n"
+    "            {\n";
+
+    for( auto & e : process_->map_id_to_action_connector_ )
+    {
+        auto & ac = * e.second;
+
+        os << "            case " << e.first << ":\n"
+              "            {\n";
+
+        write( os, * ac.get_action(), ac );
+
+        os << "            }\n"
+              "\n";
+    }
+
+    os <<
+    "            default:\n"
+    "                throw fsm::SyntaxError( \"cannot find action connector \" + std::to_string( action_connector_id ) );\n"
+    "            }\n"
+    "        }\n"
+    "    }\n"
+    "\n";
+}
+
+void CppGenHelper::write_variables( std::ostream & os )
+{
+    os << "    state_e     state_;\n";
+
+    for( auto & e : process_->mem_.map_id_to_variable_ )
+    {
+        auto & v = * e.second;
+
+        os << "    " << to_cpp_type( v.get_type() ) << " " << to_variable_name( v.get_id() ) << ";     // " << v.get_name() << "\n";
+    }
+}
+
+std::ostream & CppGenHelper::write( std::ostream & os, const Action & l, const ActionConnector & ac )
+{
+    typedef CppGenHelper Type;
+
+    typedef std::ostream & (Type::*PPMF)( std::ostream & os, const Action & l, const ActionConnector & ac );
+
+#define MAP_ENTRY(_v)       { typeid( _v ),        & Type::write_##_v }
+
+    static const std::unordered_map<std::type_index, PPMF> funcs =
+    {
+        MAP_ENTRY( SendSignal ),
+        MAP_ENTRY( SetTimer ),
+        MAP_ENTRY( ResetTimer ),
+        MAP_ENTRY( FunctionCall ),
+        MAP_ENTRY( Task ),
+        MAP_ENTRY( Condition ),
+        MAP_ENTRY( SwitchCondition ),
+        MAP_ENTRY( NextState ),
+        MAP_ENTRY( Exit ),
+    };
+
+#undef MAP_ENTRY
+
+    auto it = funcs.find( typeid( l ) );
+
+    if( it == funcs.end() )
+    {
+        errors_.push_back( "unsupported action " + std::string( typeid( l ).name() ) + ", action connector id " + std::to_string( ac.get_id() ) );
+        return os;
+    }
+
+    return (this->*it->second)( os, l, ac );
+}
+
+std::ostream & CppGenHelper::write_SendSignal( std::ostream & os, const Action & aa, const ActionConnector & ac )
+{
+    auto & a = dynamic_cast< const SendSignal &>( aa );
+
+    if( a.target != SendSignal::target_e::ENV )
+    {
+        errors_.push_back( "signals to processes are not supported, signal " + a.name + ", action connector id " + std::to_string( ac.get_id() ) );
+    }
+
+    os << "                send_signal( " << to_literal( a.name ) << ", {";
+
+    bool is_first = true;
+
+    for( auto & e : a.arguments )
+    {
+        os << ( is_first ? " " : ", " ) << to_value( to_code( * e ) );
+
+        is_first = false;
+    }
+
+    os << ( is_first ? "} );\n" : " } );\n" );
+
+    return write_next( os, ac.get_next_id() );
+}
+
+std::ostream & CppGenHelper::write_SetTimer( std::ostream & os, const Action & aa, const ActionConnector & ac )
+{
+    auto & a = dynamic_cast< const SetTimer &>( aa );
+
+    os << "                set_timer( " << a.timer_id << ", " << convert( to_code( * a.delay ), data_type_e::DOUBLE ) << " );\n";
+
+    return write_next( os, ac.get_next_id() );
+}
+
+std::ostream & CppGenHelper::write_ResetTimer( std::ostream & os, const Action & aa, const ActionConnector & ac )
+{
+    auto & a = dynamic_cast< const ResetTimer &>( aa );
+
+    os << "                reset_timer( " << a.timer_id << " );\n";
+
+    return write_next( os, ac.get_next_id() );
+}
+
+std::ostream & CppGenHelper::write_FunctionCall( std::ostream & os, const Action & aa, const ActionConnector & ac )
+{
+    auto & a = dynamic_cast< const FunctionCall &>( aa );
+
+    os << "                std::vector<fsm::Value> arguments = {";
+
+    bool is_first = true;
+
+    for( auto & e : a.arguments )
+    {
+        os << ( is_first ? " " : ", " ) << to_value( to_code( * e.second ) );
+
+        is_first = false;
+    }
+
+    os << ( is_first ? "};\n" : " };\n" );
+
+    os << "                call_function( " << to_literal( a.name ) << ", & arguments );\n";
+
+    unsigned i = 0;
+
+    for( auto & e : a.arguments )
+    {
+        if( e.first )
+            write_assignment( os, * e.second, "arguments[" + std::to_string( i ) + "]" );
+
+        ++i;
+    }
+
+    return write_next( os, ac.get_next_id() );
+}
+
+std::ostream & CppGenHelper::write_Task( std::ostream & os, const Action & aa, const ActionConnector & ac )
+{
+    auto & a = dynamic_cast< const Task &>( aa );
+
+    auto variable = process_->mem_.find_variable( a.variable_id );
+
+    if( variable == nullptr )
+    {
+        errors_.push_back( "cannot find variable " + std::to_string( a.variable_id ) );
+        return os;
+    }
+
+    os << "                " << to_variable_name( a.variable_id ) << " = " << convert( to_code( * a.expr ), variable->get_type() ) << ";\n";
+
+    return write_next( os, ac.get_next_id() );
+}
+
+std::ostream & CppGenHelper::write_Condition( std::ostream & os, const Action & aa, const ActionConnector & ac )
+{
+    auto & a = dynamic_cast< const Condition &>( aa );
+
+    std::string cond;
+
+    if( a.type == comparison_type_e::NOT )
+    {
+        cond = "! " + convert( to_code( * a.lhs ), data_type_e::BOOL );
+    }
+    else
+    {
+        auto lhs = to_code( * a.lhs );
+        auto rhs = to_code( * a.rhs );
+
+        if( lhs.type == rhs.type && lhs.type != data_type_e::UNDEF )
+            cond = lhs.code + " " + to_operator( a.type ) + " " + rhs.code;
+        else
+            cond = "compare_values( " + to_string( a.type ) + ", " + to_value( lhs ) + ", " + to_value( rhs ) + " )";
+    }
+
+    os << "                if( " << cond << " )\n"
+          "                    action_connector_id = " << ac.get_next_id() << ";\n"
+          "                else\n"
+          "                    action_connector_id = " << ac.get_alt_next_id() << ";\n"
+          "                break;\n";
+
+    return os;
+}
+
+std::ostream & CppGenHelper::write_SwitchCondition( std::ostream & os, const Action & aa, const ActionConnector & ac )
+{
+    auto & a = dynamic_cast< const SwitchCondition &>( aa );
+
+    auto & actions = ac.get_switch_actions();
+
+    assert( actions.size() == a.values.size() );
+
+    auto var = to_code( * a.var );
+
+    os << "                auto value = " << var.code << ";\n";
+
+    if( a.table && a.table->type == data_type_e::INT && var.type == data_type_e::INT )
+    {
+        // the table of Process::finalize() has no duplicates, i.e. it can be a C++ switch
+        std::map<int,int64_t> map_case_to_int;
+
+        for( auto & e : a.table->map_int_to_case )
+        {
+            map_case_to_int.insert( std::make_pair( e.second, e.first ) );
+        }
+
+        os << "                switch( value )\n"
+              "                {\n";
+
+        for( auto & e : map_case_to_int )
+        {
+            os << "                case " << e.second << ":\n"
+                  "                    action_connector_id = " << actions.at( e.first - 1 ) << ";\n"
+                  "                    break;\n";
+        }
+
+        os << "                default:\n"
+              "                    action_connector_id = " << ac.get_default_switch_action() << ";\n"
+              "                    break;\n"
+              "                }\n"
+              "                break;\n";
+
+        return os;
+    }
+
+    Code lhs { "value", var.type };
+
+    unsigned i = 0;
+
+    for( auto & e : a.values )
+    {
+        auto rhs = to_code( * e );
+
+        std::string cond;
+
+        if( lhs.type == rhs.type && lhs.type != data_type_e::UNDEF )
+            cond = lhs.code + " == " + rhs.code;
+        else
+            cond = "compare_values( fsm::comparison_type_e::EQ, " + to_value( lhs ) + ", " + to_value( rhs ) + " )";
+
+        os << "                " << ( i ? "else if( " : "if( " ) << cond << " )\n"
+              "                    action_connector_id = " << actions.at( i ) << ";\n";
+
+        ++i;
+    }
+
+    if( i )
+        os << "                else\n"
+              "                    action_connector_id = " << ac.get_default_switch_action() << ";\n";
+    else
+        os << "                action_connector_id = " << ac.get_default_switch_action() << ";\n";
+
+    os << "                break;\n";
+
+    return os;
+}
+
+std::ostream & CppGenHelper::write_NextState( std::ostream & os, const Action & aa, const ActionConnector & /* ac */ )
+{
+    auto & a = dynamic_cast< const NextState &>( aa );
+
+    if( process_->map_id_to_state_.count( a.state_id ) == 0 )
+    {
+        errors_.push_back( "cannot find state " + std::to_string( a.state_id ) );
+        return os;
+    }
+
+    os << "                state_ = state_e::" << to_state_name( a.state_id ) << ";\n"
+          "                return;\n";
+
+    return os;
+}
+
+std::ostream & CppGenHelper::write_Exit( std::ostream & os, const Action & /* aa */, const ActionConnector & /* ac */ )
+{
+    os << "                set_ended();\n"
+          "                return;\n";
+
+    return os;
+}
+
+std::ostream & CppGenHelper::write_next( std::ostream & os, element_id_t action_connector_id )
+{
+    os << "                action_connector_id = " << action_connector_id << ";\n"
+          "                break;\n";
+
+    return os;
+}
+
+std::ostream & CppGenHelper::write_assignment( std::ostream & os, const Expression & target, const std::string & value )
+{
+    element_id_t variable_id = 0;
+
+    if( typeid( target ) == typeid( ExpressionVariable ) )
+    {
+        variable_id = dynamic_cast< const ExpressionVariable &>( target ).variable_id;
+    }
+    else if( typeid( target ) == typeid( ExpressionVariableName ) )
+    {
+        auto & name = dynamic_cast< const ExpressionVariableName &>( target ).variable_name;
+
+        if( name.size() > 1 && name[0] == '$' )
+        {
+            os << "                set_argument( " << std::stoul( name.substr( 1 ) ) << ", " << value << " );\n";
+            return os;
+        }
+
+        variable_id = process_->names_.find_element( name );
+    }
+
+    auto variable = process_->mem_.find_variable( variable_id );
+
+    if( variable == nullptr )
+    {
+        errors_.push_back( "output argument is not a variable: " + std::string( typeid( target ).name() ) );
+        return os;
+    }
+
+    os << "                " << to_variable_name( variable_id ) << " = " << convert( Code { value, data_type_e::UNDEF }, variable->get_type() ) << ";\n";
+
+    return os;
+}
+
+CppGenHelper::Code CppGenHelper::to_code( const Expression & expr )
+{
+    if( typeid( expr ) == typeid( ExpressionValue ) )
+    {
+        Value value;
+
+        dynamic_cast< const ExpressionValue &>( expr ).value.get( & value );
+
+        return Code { to_literal( value ), value.type };
+    }
+    else if( typeid( expr ) == typeid( ExpressionVariable ) )
+    {
+        return to_code_element( dynamic_cast< const ExpressionVariable &>( expr ).variable_id );
+    }
+    else if( typeid( expr ) == typeid( ExpressionVariableName ) )
+    {
+        auto & name = dynamic_cast< const ExpressionVariableName &>( expr ).variable_name;
+
+        // signal arguments exist at runtime only
+        if( name.size() > 1 && name[0] == '$' )
+            return Code { "get_argument( " + std::to_string( std::stoul( name.substr( 1 ) ) ) + " )", data_type_e::UNDEF };
+
+        return to_code_element( process_->names_.find_element( name ) );
+    }
+    else if( typeid( expr ) == typeid( UnaryExpression ) )
+    {
+        return to_code_UnaryExpression( expr );
+    }
+    else if( typeid( expr ) == typeid( BinaryExpression ) )
+    {
+        return to_code_BinaryExpression( expr );
+    }
+
+    errors_.push_back( "unsupported expression " + std::string( typeid( expr ).name() ) );
+
+    return Code { "fsm::Value()", data_type_e::UNDEF };
+}
+
+CppGenHelper::Code CppGenHelper::to_code_element( element_id_t id )
+{
+    auto variable = process_->mem_.find_variable( id );
+
+    if( variable != nullptr )
+        return Code { to_variable_name( id ), variable->get_type() };
+
+    auto constant = process_->mem_.find_constant( id );
+
+    if( constant != nullptr )
+    {
+        Value value;
+
+        constant->get( & value );
+
+        return Code { to_literal( value ), value.type };
+    }
+
+    errors_.push_back( "cannot find variable or constant " + std::to_string( id ) );
+
+    return Code { "fsm::Value()", data_type_e::UNDEF };
+}
+
+CppGenHelper::Code CppGenHelper::to_code_UnaryExpression( const Expression & expr )
+{
+    auto & a = dynamic_cast< const UnaryExpression &>( expr );
+
+    auto op = to_code( * a.op );
+
+    if( a.type == unary_operation_type_e::NOT && op.type == data_type_e::BOOL )
+        return Code { "( ! " + op.code + " )", data_type_e::BOOL };
+
+    if( a.type == unary_operation_type_e::NEG && ( op.type == data_type_e::INT || op.type == data_type_e::DOUBLE ) )
+        return Code { "( - " + op.code + " )", op.type };
+
+    return Code { "unary_operation( " + to_string( a.type ) + ", " + to_value( op ) + " )", data_type_e::UNDEF };
+}
+
+CppGenHelper::Code CppGenHelper::to_code_BinaryExpression( const Expression & expr )
+{
+    auto & a = dynamic_cast< const BinaryExpression &>( expr );
+
+    auto lhs = to_code( * a.lhs );
+    auto rhs = to_code( * a.rhs );
+
+    // the same operations as in TypedOperations, the rest is left to anyvalue
+    static const std::map<std::pair<data_type_e,binary_operation_type_e>,std::string> native_operators =
+    {
+        { { data_type_e::BOOL,      binary_operation_type_e::AND },     "&&" },
+        { { data_type_e::BOOL,      binary_operation_type_e::OR },      "||" },
+        { { data_type_e::INT,       binary_operation_type_e::PLUS },    "+" },
+        { { data_type_e::INT,       binary_operation_type_e::MINUS },   "-" },
+        { { data_type_e::INT,       binary_operation_type_e::MUL },     "*" },
+        { { data_type_e::DOUBLE,    binary_operation_type_e::PLUS },    "+" },
+        { { data_type_e::DOUBLE,    binary_operation_type_e::MINUS },   "-" },
+        { { data_type_e::DOUBLE,    binary_operation_type_e::MUL },     "*" },
+        { { data_type_e::DOUBLE,    binary_operation_type_e::DIV },     "/" },
+        { { data_type_e::STRING,    binary_operation_type_e::PLUS },    "+" },
+    };
+
+    if( lhs.type == rhs.type )
+    {
+        auto it = native_operators.find( std::make_pair( lhs.type, a.type ) );
+
+        if( it != native_operators.end() )
+            return Code { "( " + lhs.code + " " + it->second + " " + rhs.code + " )", lhs.type };
+    }
+
+    return Code { "binary_operation( " + to_string( a.type ) + ", " + to_value( lhs ) + ", " + to_value( rhs ) + " )", data_type_e::UNDEF };
+}
+
+std::string CppGenHelper::convert( const Code & code, data_type_e type )
+{
+    if( code.type == type )
+        return code.code;
+
+    if( type == data_type_e::UNDEF )
+        return to_value( code );
+
+    if( type == data_type_e::DOUBLE && code.type == data_type_e::INT )
+        return "double( " + code.code + " )";
+
+    return to_converter( type ) + "( " + to_value( code ) + " )";
+}
+
+std::string CppGenHelper::to_value( const Code & code )
+{
+    if( code.type == data_type_e::UNDEF )
+        return code.code;
+
+    return "to_value( " + code.code + " )";
+}
+
+std::string CppGenHelper::to_literal( const Value & value )
+{
+    switch( value.type )
+    {
+    case data_type_e::BOOL:
+        return value.arg_b ? "true" : "false";
+
+    case data_type_e::INT:
+        return "int64_t( " + std::to_string( value.arg_i ) + " )";
+
+    case data_type_e::DOUBLE:
+    {
+        if( std::isnan( value.arg_d ) )
+            return "std::numeric_limits<double>::quiet_NaN()";
+
+        if( std::isinf( value.arg_d ) )
+            return value.arg_d > 0 ? "std::numeric_limits<double>::infinity()" : "( - std::numeric_limits<double>::infinity() )";
+
+        std::ostringstream os;
+
+        os << std::setprecision( 17 ) << value.arg_d;
+
+        auto res = os.str();
+
+        // otherwise 1.0 / 2.0 would be an integer division
+        if( res.find_first_of( ".e" ) == std::string::npos )
+            res += ".0";
+
+        return res;
+    }
+
+    case data_type_e::STRING:
+        return "std::string( " + to_literal( value.arg_s ) + " )";
+
+    default:
+        return "fsm::Value()";
+    }
+}
+
+std::string CppGenHelper::to_literal( const std::string & s )
+{
+    std::ostringstream os;
+
+    os << "\"";
+
+    for( auto c : s )
+    {
+        switch( c )
+        {
+        case '"':   os << "\\\""; break;
+        case '\\':  os << "\\\\"; break;
+        case '\n':  os << "\\n"; break;
+        case '\r':  os << "\\r"; break;
+        case '\t':  os << "\\t"; break;
+        default:
+            if( static_cast<unsigned char>( c ) < 0x20 || c == 0x7f )
+                os << "\\" << std::oct << std::setw( 3 ) << std::setfill( '0' ) << unsigned( static_cast<unsigned char>( c ) ) << std::dec;
+            else
+                os << c;
+        }
+    }
+
+    os << "\"";
+
+    return os.str();
+}
+
+std::string CppGenHelper::to_cpp_type( data_type_e type )
+{
+    switch( type )
+    {
+    case data_type_e::BOOL:
+        return "bool";
+    case data_type_e::INT:
+        return "int64_t";
+    case data_type_e::DOUBLE:
+        return "double";
+    case data_type_e::STRING:
+        return "std::string";
+    default:
+        return "fsm::Value";
+    }
+}
+
+std::string CppGenHelper::to_converter( data_type_e type )
+{
+    switch( type )
+    {
+    case data_type_e::BOOL:
+        return "to_bool";
+    case data_type_e::INT:
+        return "to_int";
+    case data_type_e::DOUBLE:
+        return "to_double";
+    case data_type_e::STRING:
+        return "to_string";
+    default:
+        return "to_value";
+    }
+}
+
+std::string CppGenHelper::to_variable_name( element_id_t id )
+{
+    return "var_" + std::to_string( id ) + "_";
+}
+
+std::string CppGenHelper::to_state_name( element_id_t id )
+{
+    return "STATE_" + std::to_string( id );
+}
+
+std::string CppGenHelper::to_string( comparison_type_e type )
+{
+    static const std::map<comparison_type_e,std::string> m =
+    {
+        { TUPLE_VAL_STR( comparison_type_e::EQ ) },
+        { TUPLE_VAL_STR( comparison_type_e::NEQ ) },
+        { TUPLE_VAL_STR( comparison_type_e::LT ) },
+        { TUPLE_VAL_STR( comparison_type_e::LE ) },
+        { TUPLE_VAL_STR( comparison_type_e::GT ) },
+        { TUPLE_VAL_STR( comparison_type_e::GE ) },
+        { TUPLE_VAL_STR( comparison_type_e::NOT ) },
+    };
+
+    return "fsm::" + m.at( type );
+}
+
+std::string CppGenHelper::to_string( unary_operation_type_e type )
+{
+    static const std::map<unary_operation_type_e,std::string> m =
+    {
+        { TUPLE_VAL_STR( unary_operation_type_e::NOT ) },
+        { TUPLE_VAL_STR( unary_operation_type_e::NEG ) },
+    };
+
+    return "fsm::" + m.at( type );
+}
+
+std::string CppGenHelper::to_string( binary_operation_type_e type )
+{
+    static const std::map<binary_operation_type_e,std::string> m =
+    {
+        { TUPLE_VAL_STR( binary_operation_type_e::AND ) },
+        { TUPLE_VAL_STR( binary_operation_type_e::OR ) },
+        { TUPLE_VAL_STR( binary_operation_type_e::PLUS ) },
+        { TUPLE_VAL_STR( binary_operation_type_e::MINUS ) },
+        { TUPLE_VAL_STR( binary_operation_type_e::MUL ) },
+        { TUPLE_VAL_STR( binary_operation_type_e::DIV ) },
+    };
+
+    return "fsm::" + m.at( type );
+}
+
+std::string CppGenHelper::to_operator( comparison_type_e type )
+{
+    switch( type )
+    {
+    case comparison_type_e::EQ:
+        return "==";
+    case comparison_type_e::NEQ:
+        return "!=";
+    case comparison_type_e::LT:
+        return "<";
+    case comparison_type_e::LE:
+        return "<=";
+    case comparison_type_e::GT:
+        return ">";
+    default:
+        return ">=";
+    }
+}
+
+} // namespace fsm
@@ -0,0 +1,113 @@
+/*
+
+FSM. C++ code generator.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11636 $ $Date:: 2019-06-05 #$ $Author: serge $
+
+#ifndef LIB_FSM__CPP_GEN_HELPER_H
+#define LIB_FSM__CPP_GEN_HELPER_H
+
+#include <string>
+#include <vector>               // std::vector
+#include <ostream>              // std::ostream
+
+#include "elements.h"           // Value
+#include "expression.h"         // Expression
+#include "action_connector.h"   // ActionConnector
+
+namespace fsm {
+
+class Process;
+
+// generates a NativeProcess implementing the definition of the process, unsupported elements are emitted as #error
+class CppGenHelper
+{
+public:
+
+    CppGenHelper( const Process * l, const std::string & class_name );
+
+    std::ostream & write( std::ostream & os );
+
+private:
+
+    // code of an expression, type UNDEF - the code evaluates to Value
+    struct Code
+    {
+        std::string     code;
+        data_type_e     type;
+    };
+
+private:
+
+    void write_class_begin( std::ostream & os );
+    void write_constructor( std::ostream & os );
+    void write_states( std::ostream & os );
+    void write_signal_handlers( std::ostream & os );
+    void write_action_connectors( std::ostream & os );
+    void write_variables( std::ostream & os );
+
+    std::ostream & write( std::ostream & os, const Action & l, const ActionConnector & ac );
+
+    std::ostream & write_SendSignal( std::ostream & os, const Action & l, const ActionConnector & ac );
+    std::ostream & write_SetTimer( std::ostream & os, const Action & l, const ActionConnector & ac );
+    std::ostream & write_ResetTimer( std::ostream & os, const Action & l, const ActionConnector & ac );
+    std::ostream & write_FunctionCall( std::ostream & os, const Action & l, const ActionConnector & ac );
+    std::ostream & write_Task( std::ostream & os, const Action & l, const ActionConnector & ac );
+    std::ostream & write_Condition( std::ostream & os, const Action & l, const ActionConnector & ac );
+    std::ostream & write_SwitchCondition( std::ostream & os, const Action & l, const ActionConnector & ac );
+    std::ostream & write_NextState( std::ostream & os, const Action & l, const ActionConnector & ac );
+    std::ostream & write_Exit( std::ostream & os, const Action & l, const ActionConnector & ac );
+
+    static std::ostream & write_next( std::ostream & os, element_id_t action_connector_id );
+    std::ostream & write_assignment( std::ostream & os, const Expression & target, const std::string & value );
+
+    Code to_code( const Expression & expr );
+    Code to_code_element( element_id_t id );
+    Code to_code_UnaryExpression( const Expression & expr );
+    Code to_code_BinaryExpression( const Expression & expr );
+
+    static std::string convert( const Code & code, data_type_e type );
+    static std::string to_value( const Code & code );
+
+    static std::string to_literal( const Value & value );
+    static std::string to_literal( const std::string & s );
+    static std::string to_cpp_type( data_type_e type );
+    static std::string to_converter( data_type_e type );
+    static std::string to_variable_name( element_id_t id );
+    static std::string to_state_name( element_id_t id );
+
+    static std::string to_string( comparison_type_e type );
+    static std::string to_string( unary_operation_type_e type );
+    static std::string to_string( binary_operation_type_e type );
+    static std::string to_operator( comparison_type_e type );
+
+private:
+
+    const Process   * process_;
+
+    std::string     class_name_;
+
+    // reported as #error at the top of the file
+    std::vector<std::string>    errors_;
+};
+
+} // namespace fsm
+
+#endif // LIB_FSM__CPP_GEN_HELPER_H
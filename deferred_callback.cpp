@@ -0,0 +1,117 @@
+/*
+
+FSM. Callback holding signals until their journal record is durable.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11680 $ $Date:: 2019-06-28 #$ $Author: serge $
+
+#include "deferred_callback.h"  // self
+
+#include "utils/mutex_helper.h"     // MUTEX_SCOPE_LOCK
+
+namespace fsm {
+
+DeferredCallback::DeferredCallback():
+        callback_( nullptr ),
+        is_deferred_( false )
+{
+}
+
+DeferredCallback::~DeferredCallback()
+{
+}
+
+void DeferredCallback::init( ICallback * callback )
+{
+    callback_   = callback;
+}
+
+void DeferredCallback::set_deferred( bool is_deferred )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    is_deferred_    = is_deferred;
+}
+
+void DeferredCallback::handle_send_signal( uint32_t process_id, const std::string & name, const std::vector<Value> & arguments )
+{
+    {
+        MUTEX_SCOPE_LOCK( mutex_ );
+
+        if( is_deferred_ )
+        {
+            held_signals_.push_back( HeldSignal { 0, process_id, name, arguments } );
+            return;
+        }
+    }
+
+    callback_->handle_send_signal( process_id, name, arguments );
+}
+
+void DeferredCallback::handle_function_call( uint32_t process_id, const std::string & name, const std::vector<Value*> & arguments )
+{
+    callback_->handle_function_call( process_id, name, arguments );
+}
+
+void DeferredCallback::handle_process_error( uint32_t process_id, const std::string & error )
+{
+    callback_->handle_process_error( process_id, error );
+}
+
+void DeferredCallback::handle_overload( bool is_overloaded, uint32_t queue_depth )
+{
+    callback_->handle_overload( is_overloaded, queue_depth );
+}
+
+void DeferredCallback::commit( uint64_t record )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    // the uncommitted signals are at the end
+    for( auto it = held_signals_.rbegin(); it != held_signals_.rend() && it->record == 0; ++it )
+    {
+        it->record  = record;
+    }
+}
+
+void DeferredCallback::release( uint64_t durable_record )
+{
+    MUTEX_SCOPE_LOCK( release_mutex_ );
+
+    std::deque<HeldSignal> signals;
+
+    {
+        MUTEX_SCOPE_LOCK( mutex_ );
+
+        while( held_signals_.empty() == false && held_signals_.front().record != 0 && held_signals_.front().record <= durable_record )
+        {
+            signals.push_back( std::move( held_signals_.front() ) );
+
+            held_signals_.pop_front();
+        }
+    }
+
+    // the callback is called unlocked, it may send signals to processes
+    for( auto & e : signals )
+    {
+        callback_->handle_send_signal( e.process_id, e.name, e.arguments );
+    }
+}
+
+} // namespace fsm
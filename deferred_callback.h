@@ -0,0 +1,89 @@
+/*
+
+FSM. Callback holding signals until their journal record is durable.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11680 $ $Date:: 2019-06-28 #$ $Author: serge $
+
+#ifndef LIB_FSM__DEFERRED_CALLBACK_H
+#define LIB_FSM__DEFERRED_CALLBACK_H
+
+#include <cstdint>              // uint64_t
+#include <deque>                // std::deque
+#include <mutex>                // std::mutex
+
+#include "i_callback.h"         // ICallback
+
+namespace fsm {
+
+// passes calls to the callback, if deferring is enabled, signals sent by processes are held
+// until the journal record of their transition is durable (write-ahead), function calls are passed at once,
+// as the process needs their results, they are recorded in the journal with the changed variables
+class DeferredCallback: public ICallback
+{
+public:
+    DeferredCallback();
+    ~DeferredCallback();
+
+    void init( ICallback * callback );
+
+    void set_deferred( bool is_deferred );
+
+    void handle_send_signal( uint32_t process_id, const std::string & name, const std::vector<Value> & arguments ) override;
+    void handle_function_call( uint32_t process_id, const std::string & name, const std::vector<Value*> & arguments ) override;
+    void handle_process_error( uint32_t process_id, const std::string & error ) override;
+    void handle_overload( bool is_overloaded, uint32_t queue_depth ) override;
+
+    // the signals held so far belong to the journal record
+    void commit( uint64_t record );
+
+    // passes the signals of the records up to the durable one, in the order they were sent
+    void release( uint64_t durable_record );
+
+private:
+    DeferredCallback( const DeferredCallback & )              = delete;
+    DeferredCallback & operator=( const DeferredCallback & )  = delete;
+
+private:
+
+    struct HeldSignal
+    {
+        uint64_t                record;     // 0 - not committed yet
+        uint32_t                process_id;
+        std::string             name;
+        std::vector<Value>      arguments;
+    };
+
+private:
+
+    ICallback                   * callback_;
+
+    // serializes the release, so that the signals are passed in order, is locked before mutex_
+    std::mutex                  release_mutex_;
+
+    std::mutex                  mutex_;
+
+    bool                        is_deferred_;
+
+    std::deque<HeldSignal>      held_signals_;
+};
+
+} // namespace fsm
+
+#endif // LIB_FSM__DEFERRED_CALLBACK_H
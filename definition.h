@@ -0,0 +1,68 @@
+/*
+
+FSM. Process definition.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11627 $ $Date:: 2019-05-30 #$ $Author: serge $
+
+#ifndef LIB_FSM__DEFINITION_H
+#define LIB_FSM__DEFINITION_H
+
+#include <cstdint>              // uint32_t
+#include <string>               // std::string
+#include <memory>               // std::shared_ptr
+#include <functional>           // std::function
+
+#include "string_pool.h"        // StringPool
+#include "execution_profile.h"  // ExecutionProfile
+
+namespace fsm {
+
+class Process;
+
+// versioned initializer of processes, is shared by all its instances and freed together with the last one
+struct Definition
+{
+    typedef std::function<void( Process * process )> Initializer;
+
+    Definition( const std::string & name, uint32_t version, const Initializer & initializer ):
+        name( name ),
+        version( version ),
+        initializer( initializer ),
+        string_pool( new StringPool ),
+        profile( new ExecutionProfile )
+    {
+    }
+
+    std::string     name;
+    uint32_t        version;
+    Initializer     initializer;
+
+    // string constants of all instances
+    std::unique_ptr<StringPool>     string_pool;
+
+    // counters of all instances, is filled if profiling is enabled in FsmManager
+    std::unique_ptr<ExecutionProfile>   profile;
+};
+
+typedef std::shared_ptr<const Definition> DefinitionPtr;
+
+} // namespace fsm
+
+#endif // LIB_FSM__DEFINITION_H
@@ -0,0 +1,290 @@
+/*
+
+FSM. Queue of events with priority lanes.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11653 $ $Date:: 2019-06-13 #$ $Author: serge $
+
+#include "event_queue.h"        // self
+
+#include <cassert>              // assert
+#include <algorithm>            // std::max
+
+#include "utils/mutex_helper.h"     // MUTEX_SCOPE_LOCK
+
+namespace fsm {
+
+EventQueue::EventQueue():
+        depth_( 0 ),
+        max_depth_( 0 ),
+        high_watermark_( 0 ),
+        low_watermark_( 0 ),
+        policy_( overload_policy_e::REJECT ),
+        is_overloaded_( false ),
+        limit_stats_( LimitStats { 0, 0, 0 } )
+{
+}
+
+EventQueue::~EventQueue()
+{
+    for( auto & l : lanes_ )
+    {
+        for( auto e : l.events )
+        {
+            delete e;
+        }
+    }
+}
+
+bool EventQueue::init( const std::vector<unsigned> & max_bursts, std::string * error_msg )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    if( max_bursts.empty() )
+    {
+        * error_msg = "no lanes";
+        return false;
+    }
+
+    assert( lanes_.empty() );
+
+    lanes_.resize( max_bursts.size() );
+
+    for( unsigned i = 0; i < max_bursts.size(); ++i )
+    {
+        lanes_[i].max_burst = max_bursts[i];
+        lanes_[i].burst     = 0;
+        lanes_[i].stats     = LaneStats { 0, 0, 0, 0 };
+    }
+
+    return true;
+}
+
+bool EventQueue::init_limit(
+        std::size_t         max_depth,
+        std::size_t         high_watermark,
+        std::size_t         low_watermark,
+        overload_policy_e   policy,
+        const Predicate     & is_sheddable,
+        std::string         * error_msg )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    if( max_depth == 0 )
+    {
+        * error_msg = "max depth must not be 0";
+        return false;
+    }
+
+    if( high_watermark > max_depth || low_watermark >= high_watermark )
+    {
+        * error_msg = "invalid watermarks: high " + std::to_string( high_watermark ) + ", low " + std::to_string( low_watermark )
+                + ", max depth " + std::to_string( max_depth );
+        return false;
+    }
+
+    assert( is_sheddable );
+
+    max_depth_      = max_depth;
+    high_watermark_ = high_watermark;
+    low_watermark_  = low_watermark;
+    policy_         = policy;
+    is_sheddable_   = is_sheddable;
+
+    return true;
+}
+
+unsigned EventQueue::get_num_lanes() const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    return lanes_.size();
+}
+
+bool EventQueue::push( unsigned lane, const ev::Object * req, const ev::Object ** dropped, watermark_e * watermark )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    assert( lane < lanes_.size() );
+
+    * dropped   = nullptr;
+    * watermark = watermark_e::NONE;
+
+    if( max_depth_ != 0 && depth_ >= max_depth_ && is_sheddable_( * req ) )
+    {
+        if( policy_ == overload_policy_e::DROP_OLDEST )
+        {
+            * dropped = drop_oldest_sheddable();
+        }
+
+        if( * dropped == nullptr )
+        {
+            ++limit_stats_.num_rejected;
+            return false;
+        }
+
+        ++limit_stats_.num_dropped;
+    }
+
+    auto & l = lanes_[ lane ];
+
+    l.events.push_back( req );
+
+    l.stats.depth       = l.events.size();
+    l.stats.max_depth   = std::max( l.stats.max_depth, l.stats.depth );
+
+    ++l.stats.num_pushed;
+
+    ++depth_;
+
+    if( max_depth_ != 0 && is_overloaded_ == false && depth_ >= high_watermark_ )
+    {
+        is_overloaded_  = true;
+        * watermark     = watermark_e::HIGH;
+
+        ++limit_stats_.num_overloads;
+    }
+
+    return true;
+}
+
+const ev::Object * EventQueue::pop( watermark_e * watermark )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    * watermark = watermark_e::NONE;
+
+    auto i = find_lane( 0 );
+
+    if( i == lanes_.size() )
+        return nullptr;
+
+    // each lane counts its own burst, so a lane that gets a yielded turn may pass it to the next lower one
+    while( true )
+    {
+        auto lower = find_lane( i + 1 );
+
+        if( lower == lanes_.size() )
+        {
+            lanes_[i].burst = 0;
+            break;
+        }
+
+        if( lanes_[i].max_burst != 0 && lanes_[i].burst >= lanes_[i].max_burst )
+        {
+            lanes_[i].burst = 0;
+
+            ++lanes_[i].stats.num_yields;
+
+            i = lower;
+            continue;
+        }
+
+        ++lanes_[i].burst;
+        break;
+    }
+
+    auto & l = lanes_[i];
+
+    auto res = l.events.front();
+
+    l.events.pop_front();
+
+    l.stats.depth   = l.events.size();
+
+    --depth_;
+
+    if( is_overloaded_ && depth_ <= low_watermark_ )
+    {
+        is_overloaded_  = false;
+        * watermark     = watermark_e::LOW;
+    }
+
+    return res;
+}
+
+std::size_t EventQueue::get_depth() const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    return depth_;
+}
+
+bool EventQueue::is_overloaded() const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    return is_overloaded_;
+}
+
+void EventQueue::get_stats( std::vector<LaneStats> * stats ) const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    stats->clear();
+
+    for( auto & l : lanes_ )
+    {
+        stats->push_back( l.stats );
+    }
+}
+
+void EventQueue::get_limit_stats( LimitStats * stats ) const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    * stats = limit_stats_;
+}
+
+unsigned EventQueue::find_lane( unsigned first ) const
+{
+    for( unsigned i = first; i < lanes_.size(); ++i )
+    {
+        if( lanes_[i].events.empty() == false )
+            return i;
+    }
+
+    return lanes_.size();
+}
+
+const ev::Object * EventQueue::drop_oldest_sheddable()
+{
+    for( auto l = lanes_.rbegin(); l != lanes_.rend(); ++l )
+    {
+        for( auto it = l->events.begin(); it != l->events.end(); ++it )
+        {
+            if( is_sheddable_( ** it ) )
+            {
+                auto res = * it;
+
+                l->events.erase( it );
+
+                l->stats.depth  = l->events.size();
+
+                --depth_;
+
+                return res;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+} // namespace fsm
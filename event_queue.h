@@ -0,0 +1,149 @@
+/*
+
+FSM. Queue of events with priority lanes.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11653 $ $Date:: 2019-06-13 #$ $Author: serge $
+
+#ifndef LIB_FSM__EVENT_QUEUE_H
+#define LIB_FSM__EVENT_QUEUE_H
+
+#include <cstdint>              // uint64_t
+#include <deque>                // std::deque
+#include <string>               // std::string
+#include <vector>               // std::vector
+#include <mutex>                // std::mutex
+#include <functional>           // std::function
+
+#include "object.h"             // Object
+
+namespace fsm {
+
+// events in lanes of decreasing priority, lane 0 is served first, owns the queued events,
+// a lane yields one event to the lower lanes after max_burst events in a row, i.e. they are not starved,
+// the yielded turn is passed further down if the next lane has used up its own burst,
+// optionally the total depth is limited for sheddable events, others are always admitted
+class EventQueue
+{
+public:
+
+    enum class overload_policy_e
+    {
+        REJECT,         // the new event is rejected
+        DROP_OLDEST     // the oldest sheddable event of the lowest lane is dropped, if there is none the new event is rejected
+    };
+
+    enum class watermark_e
+    {
+        NONE,
+        HIGH,           // the depth reached the high watermark
+        LOW             // the depth fell to the low watermark after the high one
+    };
+
+    typedef std::function<bool( const ev::Object & req )>  Predicate;
+
+    struct LaneStats
+    {
+        std::size_t     depth;
+        std::size_t     max_depth;
+        uint64_t        num_pushed;
+        uint64_t        num_yields;     // events served from lower lanes because of max_burst
+    };
+
+    struct LimitStats
+    {
+        uint64_t        num_rejected;
+        uint64_t        num_dropped;
+        uint64_t        num_overloads;  // high watermark reached
+    };
+
+public:
+    EventQueue();
+    ~EventQueue();
+
+    // max_burst per lane, 0 - unlimited
+    bool init( const std::vector<unsigned> & max_bursts, std::string * error_msg );
+
+    // optional, low_watermark < high_watermark <= max_depth
+    bool init_limit(
+            std::size_t         max_depth,
+            std::size_t         high_watermark,
+            std::size_t         low_watermark,
+            overload_policy_e   policy,
+            const Predicate     & is_sheddable,
+            std::string         * error_msg );
+
+    unsigned get_num_lanes() const;
+
+    // returns false if the event is rejected, it is not deleted then,
+    // dropped - the event dropped to admit the new one or nullptr, it is not deleted either
+    bool push( unsigned lane, const ev::Object * req, const ev::Object ** dropped, watermark_e * watermark );
+
+    // returns nullptr if the queue is empty
+    const ev::Object * pop( watermark_e * watermark );
+
+    std::size_t get_depth() const;
+    bool is_overloaded() const;
+
+    void get_stats( std::vector<LaneStats> * stats ) const;
+    void get_limit_stats( LimitStats * stats ) const;
+
+private:
+    EventQueue( const EventQueue & )              = delete;
+    EventQueue & operator=( const EventQueue & )  = delete;
+
+    // first non-empty lane starting from the given one, returns get_num_lanes() if there is none
+    unsigned find_lane( unsigned first ) const;
+
+    const ev::Object * drop_oldest_sheddable();
+
+private:
+
+    struct Lane
+    {
+        std::deque<const ev::Object*>   events;
+
+        unsigned                        max_burst;
+        unsigned                        burst;      // events served since the last yield while a lower lane was waiting
+
+        LaneStats                       stats;
+    };
+
+private:
+
+    mutable std::mutex          mutex_;
+
+    std::vector<Lane>           lanes_;
+
+    std::size_t                 depth_;
+
+    std::size_t                 max_depth_;         // 0 - unlimited
+    std::size_t                 high_watermark_;
+    std::size_t                 low_watermark_;
+    overload_policy_e           policy_;
+    Predicate                   is_sheddable_;
+
+    bool                        is_overloaded_;
+
+    LimitStats                  limit_stats_;
+};
+
+} // namespace fsm
+
+#endif // LIB_FSM__EVENT_QUEUE_H
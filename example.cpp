@@ -12,6 +12,7 @@
 #include "parser.h"         // Parser
 #include "str_helper.h"     // StrHelper
 #include "sdl_gr_helper.h"  // SdlGrHelper
+#include "cpp_gen_helper.h" // CppGenHelper
 
 class Callback: virtual public fsm::ICallback
 {
@@ -192,6 +193,7 @@ void init_fsm_1( fsm::Process * fsm );
 void init_fsm_2( fsm::Process * fsm );
 void init_fsm_3( fsm::Process * fsm );
 void init_fsm_4( fsm::Process * fsm );
+fsm::NativeProcess::Factory get_fsm_5_factory();
 
 bool init_fsm( fsm::Process * fsm, unsigned fsm_num )
 {
@@ -223,6 +225,16 @@ bool init_fsm( fsm::Process * fsm, unsigned fsm_num )
 
 bool create_fsm( fsm::FsmManager * fsm_man, uint32_t * process_id, unsigned fsm_num )
 {
+    if( fsm_num == 5 )
+    {
+        // defined at compile time
+        fsm_man->register_native_definition( "fsm_5", get_fsm_5_factory() );
+
+        * process_id    = fsm_man->create_process( "fsm_5" );
+
+        return true;
+    }
+
     auto id = fsm_man->create_process();
 
     auto & mutex = fsm_man->get_mutex();
@@ -266,11 +278,13 @@ int main( int argc, char **argv )
 
     if( argc <= 1 )
     {
-        std::cout << "USAGE: ./example <fsm_num> [--sdlgr], where fsm_num is 1, 2 or 3" << std::endl;
+        std::cout << "USAGE: ./example <fsm_num> [--sdlgr|--cpp|--heat], where fsm_num is 1, 2, 3, 4 or 5 (compile-time defined 3)" << std::endl;
         return EXIT_SUCCESS;
     }
 
     bool make_sdl_graph = false;
+    bool make_cpp       = false;
+    bool make_heat_map  = false;
 
     if( argc == 3 )
     {
@@ -280,6 +294,14 @@ int main( int argc, char **argv )
         {
             make_sdl_graph  = true;
         }
+        else if( arg2 == "--cpp" )
+        {
+            make_cpp        = true;
+        }
+        else if( arg2 == "--heat" )
+        {
+            make_heat_map   = true;
+        }
         else
         {
             std::cout << "ERROR: unsupported param = " << arg2 << std::endl;
@@ -299,6 +321,12 @@ int main( int argc, char **argv )
         return EXIT_FAILURE;
     }
 
+    if( ( make_sdl_graph || make_cpp || make_heat_map ) && fsm_man.find_process( process_id ) == nullptr )
+    {
+        std::cout << "ERROR: fsm_num = " << fsm_num << " is not interpreted" << std::endl;
+        return EXIT_FAILURE;
+    }
+
     if( make_sdl_graph )
     {
         std::string name        = "process_" + std::to_string( fsm_num );
@@ -319,6 +347,34 @@ int main( int argc, char **argv )
         return EXIT_SUCCESS;
     }
 
+    if( make_cpp )
+    {
+        std::string name        = "process_" + std::to_string( fsm_num );
+        std::string file_name   = name + ".cpp";
+
+        std::cout << "generating C++ code - " << file_name << std::endl;
+
+        std::ofstream out( file_name );
+
+        out << "// generated by fsm, register with FsmManager::register_native_definition( <name>, & Process_" << fsm_num << "::create )\n";
+        out << "\n";
+
+        fsm::CppGenHelper( fsm_man.find_process( process_id ), "Process_" + std::to_string( fsm_num ) ).write( out );
+
+        out.close();
+
+        return EXIT_SUCCESS;
+    }
+
+    fsm::ExecutionProfile profile;
+
+    if( make_heat_map )
+    {
+        MUTEX_SCOPE_LOCK( fsm_man.get_mutex() );
+
+        fsm_man.find_process( process_id )->set_profile( & profile );
+    }
+
     sched.run();
     fsm_man.start();
 
@@ -335,6 +391,27 @@ int main( int argc, char **argv )
 
     sched.shutdown();
 
+    if( make_heat_map )
+    {
+        std::string name        = "process_" + std::to_string( fsm_num ) + "_heat";
+        std::string file_name   = name + ".gv";
+
+        std::cout << "generating SDL/GR graph with execution profile - " << file_name << std::endl;
+
+        // the profiled process may be already deleted, a new instance of the same definition has the same element ids
+        create_fsm( & fsm_man, & process_id, fsm_num );
+
+        std::ofstream out( file_name );
+
+        out << "# generated by fsm\n";
+        out << "# execute: FL=" << name << "; dot -l sdl.ps -Tps $FL.gv -o $FL.ps; ps2pdf $FL.ps $FL.pdf\n";
+        out << "\n";
+
+        fsm::SdlGrHelper( fsm_man.find_process( process_id ), & profile ).write( out );
+
+        out.close();
+    }
+
     std::cout << "Done! =)" << std::endl;
 
     return EXIT_SUCCESS;
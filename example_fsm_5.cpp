@@ -0,0 +1,170 @@
+#include "static_process.h" // StaticProcess
+
+// example_fsm_3 defined at compile time
+
+using namespace fsm::dsl;
+
+class Fsm5: public fsm::StaticProcess<Fsm5>
+{
+public:
+
+    enum
+    {
+        DONE        = 0,
+        CANCELLED   = 1,
+        FAILED      = 2,
+        ABORTED     = 3,
+    };
+
+    enum
+    {
+        NONE        = 0,
+        REPEAT      = 1,
+        DROP        = 2,
+    };
+
+    static const fsm::element_id_t TIMER = 1;
+
+    Fsm5( uint32_t id, uint32_t log_id, fsm::IFsm * parent, fsm::ICallback * callback, scheduler::IScheduler * scheduler ):
+            fsm::StaticProcess<Fsm5>( id, log_id, parent, callback, scheduler ),
+            response( 0 ),
+            action( 0 ),
+            action_message( 0 )
+    {
+        add_timer( TIMER, "T" );
+    }
+
+    void on_start()
+    {
+        set_timer( TIMER, 1 );
+    }
+
+    struct IDLE {};
+    struct PLAYING_MESSAGE_1 {};
+    struct PLAYING_MESSAGE_2 {};
+    struct WAITING_ACTION {};
+    struct PLAYING_MESSAGE_ACTION {};
+
+    FSM_DSL_SIGNAL( T );
+    FSM_DSL_SIGNAL( Cancel );
+    FSM_DSL_SIGNAL( ConnectionLost );
+    FSM_DSL_SIGNAL( PlayFinished );
+    FSM_DSL_SIGNAL( PlayFailed );
+    FSM_DSL_SIGNAL( TONE );
+
+    template<int MESSAGE>
+    struct PlayMessage
+    {
+        void operator()( Fsm5 & p ) const
+        {
+            p.send_signal( "ScenPlayMessage", { to_value( int64_t( MESSAGE ) ) } );
+        }
+    };
+
+    template<int TIMEOUT>
+    struct SetTimer
+    {
+        void operator()( Fsm5 & p ) const
+        {
+            p.set_timer( TIMER, TIMEOUT );
+        }
+    };
+
+    template<int CODE, const char * MESSAGE()>
+    struct ScenExit
+    {
+        void operator()( Fsm5 & p ) const
+        {
+            p.send_signal( "ScenExit", { to_value( int64_t( CODE ) ), to_value( MESSAGE() ) } );
+        }
+    };
+
+    static const char * cancelled_before()      { return "cancelled before announcement"; }
+    static const char * lost_before()           { return "connection lost before announcement"; }
+    static const char * cancelled_during()      { return "cancelled during announcement"; }
+    static const char * lost_during()           { return "connection lost during announcement"; }
+    static const char * cannot_play()           { return "cannot play sound file"; }
+    static const char * cancelled_waiting()     { return "cancelled during waiting"; }
+    static const char * lost_waiting()          { return "connection lost during waiting"; }
+    static const char * timeout()               { return "timeout"; }
+    static const char * done()                  { return "done"; }
+
+    struct HandleTone
+    {
+        void operator()( Fsm5 & p ) const
+        {
+            p.response = to_int( p.get_argument( 1 ) );
+
+            std::vector<fsm::Value> arguments = { to_value( p.response ), to_value( p.action ), to_value( p.action_message ) };
+
+            p.call_function( "convert_tone_to_action", & arguments );
+
+            p.action            = to_int( arguments[1] );
+            p.action_message    = to_int( arguments[2] );
+
+            if( p.action == DROP )
+                p.send_signal( "ScenPlayMessage", { to_value( p.action_message ) } );
+        }
+    };
+
+    struct IsDrop
+    {
+        bool operator()( const Fsm5 & p ) const
+        {
+            return p.action == DROP;
+        }
+    };
+
+    struct Feedback
+    {
+        void operator()( Fsm5 & p ) const
+        {
+            p.send_signal( "ScenFeedbackInt", { to_value( p.response ) } );
+            p.send_signal( "ScenExit", { to_value( int64_t( DONE ) ), to_value( done() ) } );
+        }
+    };
+
+    typedef List<IDLE, PLAYING_MESSAGE_1, PLAYING_MESSAGE_2, WAITING_ACTION, PLAYING_MESSAGE_ACTION> states;
+
+    typedef List<T, Cancel, ConnectionLost, PlayFinished, PlayFailed, TONE> signals;
+
+    typedef List<
+            Transition<IDLE,                    T,              PlayMessage<1>,                         PLAYING_MESSAGE_1>,
+            Transition<IDLE,                    Cancel,         ScenExit<CANCELLED, cancelled_before>,  Exit>,
+            Transition<IDLE,                    ConnectionLost, ScenExit<ABORTED, lost_before>,         Exit>,
+
+            Transition<PLAYING_MESSAGE_1,       Cancel,         ScenExit<CANCELLED, cancelled_during>,  Exit>,
+            Transition<PLAYING_MESSAGE_1,       PlayFinished,   SetTimer<1>,                            Stay>,
+            Transition<PLAYING_MESSAGE_1,       PlayFailed,     ScenExit<FAILED, cannot_play>,          Exit>,
+            Transition<PLAYING_MESSAGE_1,       ConnectionLost, ScenExit<ABORTED, lost_during>,         Exit>,
+            Transition<PLAYING_MESSAGE_1,       T,              PlayMessage<2>,                         PLAYING_MESSAGE_2>,
+
+            Transition<PLAYING_MESSAGE_2,       Cancel,         ScenExit<CANCELLED, cancelled_during>,  Exit>,
+            Transition<PLAYING_MESSAGE_2,       PlayFinished,   SetTimer<1>,                            Stay>,
+            Transition<PLAYING_MESSAGE_2,       PlayFailed,     ScenExit<FAILED, cannot_play>,          Exit>,
+            Transition<PLAYING_MESSAGE_2,       ConnectionLost, ScenExit<ABORTED, lost_during>,         Exit>,
+            Transition<PLAYING_MESSAGE_2,       T,              SetTimer<15>,                           WAITING_ACTION>,
+
+            Transition<WAITING_ACTION,          Cancel,         ScenExit<CANCELLED, cancelled_waiting>, Exit>,
+            Transition<WAITING_ACTION,          ConnectionLost, ScenExit<ABORTED, lost_waiting>,        Exit>,
+            Transition<WAITING_ACTION,          TONE,           HandleTone,                             Select<IsDrop, PLAYING_MESSAGE_ACTION, WAITING_ACTION>>,
+            Transition<WAITING_ACTION,          T,              ScenExit<DONE, timeout>,                Exit>,
+
+            // despite failed play we still proceed like it was a PlayFinished
+            Transition<PLAYING_MESSAGE_ACTION,  PlayFinished,   Feedback,                               Exit>,
+            Transition<PLAYING_MESSAGE_ACTION,  PlayFailed,     Feedback,                               Exit>,
+            Transition<PLAYING_MESSAGE_ACTION,  Cancel,         Feedback,                               Exit>,
+            Transition<PLAYING_MESSAGE_ACTION,  ConnectionLost, Feedback,                               Exit>
+            > transitions;
+
+private:
+
+    int64_t     response;
+    int64_t     action;
+    int64_t     action_message;
+};
+
+fsm::NativeProcess::Factory get_fsm_5_factory()
+{
+    return & Fsm5::create;
+}
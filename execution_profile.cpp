@@ -0,0 +1,98 @@
+/*
+
+FSM. Execution profile of a definition.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11645 $ $Date:: 2019-06-10 #$ $Author: serge $
+
+#include "execution_profile.h"  // self
+
+namespace fsm {
+
+void ExecutionProfile::add_action_connector( element_id_t action_connector_id, Duration time )
+{
+    add( & map_id_to_action_connector_, action_connector_id, time );
+}
+
+void ExecutionProfile::add_signal_handler( element_id_t signal_handler_id, Duration time )
+{
+    add( & map_id_to_signal_handler_, signal_handler_id, time );
+}
+
+void ExecutionProfile::add_edge( element_id_t action_connector_id_1, element_id_t action_connector_id_2 )
+{
+    ++map_edge_to_hits_[ std::make_pair( action_connector_id_1, action_connector_id_2 ) ];
+}
+
+const ExecutionProfile::Counter * ExecutionProfile::find_action_connector( element_id_t action_connector_id ) const
+{
+    return find( map_id_to_action_connector_, action_connector_id );
+}
+
+const ExecutionProfile::Counter * ExecutionProfile::find_signal_handler( element_id_t signal_handler_id ) const
+{
+    return find( map_id_to_signal_handler_, signal_handler_id );
+}
+
+uint64_t ExecutionProfile::get_edge_hits( element_id_t action_connector_id_1, element_id_t action_connector_id_2 ) const
+{
+    auto it = map_edge_to_hits_.find( std::make_pair( action_connector_id_1, action_connector_id_2 ) );
+
+    if( it == map_edge_to_hits_.end() )
+        return 0;
+
+    return it->second;
+}
+
+const ExecutionProfile::MapIdToCounter & ExecutionProfile::get_action_connectors() const
+{
+    return map_id_to_action_connector_;
+}
+
+const ExecutionProfile::MapIdToCounter & ExecutionProfile::get_signal_handlers() const
+{
+    return map_id_to_signal_handler_;
+}
+
+void ExecutionProfile::clear()
+{
+    map_id_to_action_connector_.clear();
+    map_id_to_signal_handler_.clear();
+    map_edge_to_hits_.clear();
+}
+
+void ExecutionProfile::add( MapIdToCounter * map, element_id_t id, Duration time )
+{
+    auto & c = ( * map )[ id ];
+
+    ++c.hits;
+    c.time  += time;
+}
+
+const ExecutionProfile::Counter * ExecutionProfile::find( const MapIdToCounter & map, element_id_t id )
+{
+    auto it = map.find( id );
+
+    if( it == map.end() )
+        return nullptr;
+
+    return & it->second;
+}
+
+} // namespace fsm
@@ -0,0 +1,82 @@
+/*
+
+FSM. Execution profile of a definition.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11645 $ $Date:: 2019-06-10 #$ $Author: serge $
+
+#ifndef LIB_FSM__EXECUTION_PROFILE_H
+#define LIB_FSM__EXECUTION_PROFILE_H
+
+#include <cstdint>              // uint64_t
+#include <map>                  // std::map
+#include <chrono>               // std::chrono::steady_clock
+
+#include "elements.h"           // element_id_t
+
+namespace fsm {
+
+// execution counters of the elements of a definition, is updated and read in the locked state of FsmManager
+class ExecutionProfile
+{
+public:
+
+    typedef std::chrono::steady_clock::duration Duration;
+
+    struct Counter
+    {
+        uint64_t    hits;
+        Duration    time;
+    };
+
+    typedef std::map<element_id_t,Counter>                              MapIdToCounter;
+    typedef std::map<std::pair<element_id_t,element_id_t>,uint64_t>     MapEdgeToHits;
+
+public:
+
+    // time of the action only, i.e. without the following action connectors
+    void add_action_connector( element_id_t action_connector_id, Duration time );
+    // time of the whole chain of actions
+    void add_signal_handler( element_id_t signal_handler_id, Duration time );
+    void add_edge( element_id_t action_connector_id_1, element_id_t action_connector_id_2 );
+
+    const Counter * find_action_connector( element_id_t action_connector_id ) const;
+    const Counter * find_signal_handler( element_id_t signal_handler_id ) const;
+    uint64_t get_edge_hits( element_id_t action_connector_id_1, element_id_t action_connector_id_2 ) const;
+
+    const MapIdToCounter & get_action_connectors() const;
+    const MapIdToCounter & get_signal_handlers() const;
+
+    void clear();
+
+private:
+
+    static void add( MapIdToCounter * map, element_id_t id, Duration time );
+    static const Counter * find( const MapIdToCounter & map, element_id_t id );
+
+private:
+
+    MapIdToCounter      map_id_to_action_connector_;
+    MapIdToCounter      map_id_to_signal_handler_;
+    MapEdgeToHits       map_edge_to_hits_;
+};
+
+} // namespace fsm
+
+#endif // LIB_FSM__EXECUTION_PROFILE_H
@@ -28,6 +28,8 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include "elements.h"           // element_id_t
 #include "elements.h"              // Value
+#include "compact_value.h"      // CompactValue
+#include "typed_operations.h"   // TypedOperations
 
 namespace fsm {
 
@@ -65,19 +67,27 @@ struct ExpressionValue: public Expression
     {
     }
 
-    Value               value;
+    // long strings are interned in the StringPool of the definition at finalize
+    CompactValue        value;
 };
 
 struct UnaryExpression: public Expression
 {
     UnaryExpression( unary_operation_type_e type, ExpressionPtr op ):
         type( type ),
-        op( op )
+        op( op ),
+        operand_type( data_type_e::UNDEF ),
+        operation( nullptr )
     {
     }
 
     unary_operation_type_e      type;
     ExpressionPtr               op;
+
+    // set by the type check in Process::finalize(), UNDEF - not known statically
+    data_type_e                 operand_type;
+    // selected by the type check, nullptr - anyvalue is used
+    TypedOperations::UnaryOperation     operation;
 };
 
 struct BinaryExpression: public Expression
@@ -87,10 +97,17 @@ struct BinaryExpression: public Expression
     ExpressionPtr               lhs;
     ExpressionPtr               rhs;
 
+    // set by the type check in Process::finalize(), UNDEF - not known statically
+    data_type_e                 operand_type;
+    // selected by the type check, nullptr - anyvalue is used
+    TypedOperations::BinaryOperation    operation;
+
     BinaryExpression( binary_operation_type_e type, ExpressionPtr lhs, ExpressionPtr rhs ):
         type( type ),
         lhs( lhs ),
-        rhs( rhs )
+        rhs( rhs ),
+        operand_type( data_type_e::UNDEF ),
+        operation( nullptr )
     {
     }
 };
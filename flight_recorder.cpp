@@ -0,0 +1,324 @@
+/*
+
+FSM. Flight recorder.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11620 $ $Date:: 2019-05-27 #$ $Author: serge $
+
+#include "flight_recorder.h"    // self
+
+#include <atomic>               // std::atomic
+#include <mutex>                // std::mutex
+#include <vector>               // std::vector
+#include <chrono>               // std::chrono::steady_clock
+#include <unistd.h>             // write
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>          // __rdtsc
+#endif
+
+#include "utils/mutex_helper.h"     // MUTEX_SCOPE_LOCK
+
+#include "process.h"            // Process
+
+namespace fsm {
+
+// is written only by its thread, dump() reads it concurrently
+struct FlightRecorder::Buffer
+{
+    uint32_t                thread_num;
+    // published with release after the entry is written
+    std::atomic<uint64_t>   num_records;
+    // seqlock of each entry, 2 * n + 1 while the record n is written into it, 2 * n + 2 after that
+    std::atomic<uint64_t>   sequences[ BUFFER_SIZE ];
+    Entry                   entries[ BUFFER_SIZE ];
+};
+
+namespace {
+
+const uint32_t MAGIC    = 0x524d5346;  // "FSMR"
+const uint32_t VERSION  = 1;
+
+struct BufferHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    thread_num;
+    uint32_t    num_entries;
+};
+
+std::atomic<bool>   is_enabled_( false );
+
+std::mutex & get_registry_mutex()
+{
+    static std::mutex m;
+
+    return m;
+}
+
+std::vector<FlightRecorder::Buffer*> & get_registry()
+{
+    static std::vector<FlightRecorder::Buffer*> registry;
+
+    return registry;
+}
+
+bool write_all( int fd, const void * data, size_t size )
+{
+    auto p = static_cast<const char*>( data );
+
+    while( size > 0 )
+    {
+        auto res = ::write( fd, p, size );
+
+        if( res <= 0 )
+            return false;
+
+        p       += res;
+        size    -= res;
+    }
+
+    return true;
+}
+
+// copies the complete entries oldest first, skips the ones being written or already overwritten by a newer record
+unsigned copy_entries( FlightRecorder::Entry * entries, const FlightRecorder::Buffer & buffer )
+{
+    auto num_records    = buffer.num_records.load( std::memory_order_acquire );
+    auto first          = ( num_records > FlightRecorder::BUFFER_SIZE ) ? num_records - FlightRecorder::BUFFER_SIZE : 0;
+
+    unsigned res = 0;
+
+    for( auto n = first; n < num_records; ++n )
+    {
+        auto index      = n % FlightRecorder::BUFFER_SIZE;
+        auto sequence   = 2 * n + 2;
+
+        auto & s = buffer.sequences[ index ];
+
+        if( s.load( std::memory_order_acquire ) != sequence )
+            continue;
+
+        entries[ res ] = buffer.entries[ index ];
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+
+        // torn, the writer has started the next round meanwhile
+        if( s.load( std::memory_order_relaxed ) != sequence )
+            continue;
+
+        ++res;
+    }
+
+    return res;
+}
+
+const char * to_string( FlightRecorder::event_type_e type )
+{
+    switch( type )
+    {
+    case FlightRecorder::event_type_e::NEXT_STATE:
+        return "NEXT_STATE";
+    case FlightRecorder::event_type_e::SIGNAL_HANDLER:
+        return "SIGNAL_HANDLER";
+    case FlightRecorder::event_type_e::ACTION_CONNECTOR:
+        return "ACTION_CONNECTOR";
+    default:
+        return "UNDEF";
+    }
+}
+
+} // namespace
+
+void FlightRecorder::set_enabled( bool is_enabled )
+{
+    is_enabled_.store( is_enabled, std::memory_order_relaxed );
+}
+
+bool FlightRecorder::is_enabled()
+{
+    return is_enabled_.load( std::memory_order_relaxed );
+}
+
+void FlightRecorder::record(
+        event_type_e    type,
+        uint32_t        process_id,
+        element_id_t    state_id,
+        element_id_t    signal_handler_id,
+        element_id_t    action_connector_id )
+{
+    if( is_enabled() == false )
+        return;
+
+    auto buffer = get_buffer();
+
+    // only this thread writes the buffer
+    auto n      = buffer->num_records.load( std::memory_order_relaxed );
+    auto index  = n % BUFFER_SIZE;
+
+    auto & s = buffer->sequences[ index ];
+
+    s.store( 2 * n + 1, std::memory_order_relaxed );
+
+    std::atomic_thread_fence( std::memory_order_release );
+
+    auto & e = buffer->entries[ index ];
+
+    e.timestamp             = get_timestamp();
+    e.type                  = type;
+    e.process_id            = process_id;
+    e.state_id              = state_id;
+    e.signal_handler_id     = signal_handler_id;
+    e.action_connector_id   = action_connector_id;
+    e.reserved              = 0;
+
+    s.store( 2 * n + 2, std::memory_order_release );
+
+    buffer->num_records.store( n + 1, std::memory_order_release );
+}
+
+FlightRecorder::Buffer * FlightRecorder::get_buffer()
+{
+    static thread_local Buffer * buffer = nullptr;
+
+    if( buffer == nullptr )
+    {
+        buffer  = new Buffer();
+
+        MUTEX_SCOPE_LOCK( get_registry_mutex() );
+
+        auto & registry = get_registry();
+
+        buffer->thread_num  = registry.size();
+
+        registry.push_back( buffer );
+    }
+
+    return buffer;
+}
+
+uint64_t FlightRecorder::get_timestamp()
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+void FlightRecorder::dump( std::ostream & os )
+{
+    MUTEX_SCOPE_LOCK( get_registry_mutex() );
+
+    std::vector<Entry> entries( BUFFER_SIZE );
+
+    for( auto b : get_registry() )
+    {
+        auto num_entries    = copy_entries( entries.data(), * b );
+
+        BufferHeader h = { MAGIC, VERSION, b->thread_num, num_entries };
+
+        os.write( reinterpret_cast<const char*>( & h ), sizeof( h ) );
+        os.write( reinterpret_cast<const char*>( entries.data() ), num_entries * sizeof( Entry ) );
+    }
+}
+
+bool FlightRecorder::dump( int fd )
+{
+    // no allocation in a crash handler, the copy is static, i.e. a concurrent dump fails
+    static std::atomic_flag is_dumping  = ATOMIC_FLAG_INIT;
+    static Entry            entries[ BUFFER_SIZE ];
+
+    if( is_dumping.test_and_set( std::memory_order_acquire ) )
+        return false;
+
+    // don't block if the crash happened while the registry was locked
+    auto & mutex = get_registry_mutex();
+
+    auto is_locked = mutex.try_lock();
+
+    bool res = true;
+
+    for( auto b : get_registry() )
+    {
+        auto num_entries    = copy_entries( entries, * b );
+
+        BufferHeader h = { MAGIC, VERSION, b->thread_num, num_entries };
+
+        res = res
+                && write_all( fd, & h, sizeof( h ) )
+                && write_all( fd, entries, num_entries * sizeof( Entry ) );
+    }
+
+    if( is_locked )
+        mutex.unlock();
+
+    is_dumping.clear( std::memory_order_release );
+
+    return res;
+}
+
+bool FlightRecorder::load( std::vector<Entry> * entries, std::istream & is )
+{
+    BufferHeader h;
+
+    while( is.read( reinterpret_cast<char*>( & h ), sizeof( h ) ) )
+    {
+        if( h.magic != MAGIC || h.version != VERSION || h.num_entries > BUFFER_SIZE )
+            return false;
+
+        auto size = entries->size();
+
+        entries->resize( size + h.num_entries );
+
+        if( ! is.read( reinterpret_cast<char*>( & ( * entries )[ size ] ), h.num_entries * sizeof( Entry ) ) )
+            return false;
+    }
+
+    return is.eof();
+}
+
+std::ostream & FlightRecorder::write( std::ostream & os, const Entry & e, const Process & process )
+{
+    auto & names = process.names_;
+
+    os << e.timestamp << " process " << e.process_id << " " << to_string( e.type )
+            << " state " << names.get_name( e.state_id ) << " (" << e.state_id << ")";
+
+    if( e.signal_handler_id )
+        os << " signal handler " << names.get_name( e.signal_handler_id ) << " (" << e.signal_handler_id << ")";
+
+    if( e.action_connector_id )
+        os << " action connector " << e.action_connector_id;
+
+    return os;
+}
+
+std::ostream & FlightRecorder::write( std::ostream & os, const std::vector<Entry> & entries, const Process & process )
+{
+    for( auto & e : entries )
+    {
+        write( os, e, process );
+        os << "\n";
+    }
+
+    return os;
+}
+
+} // namespace fsm
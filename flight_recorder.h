@@ -0,0 +1,94 @@
+/*
+
+FSM. Flight recorder.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11620 $ $Date:: 2019-05-27 #$ $Author: serge $
+
+#ifndef LIB_FSM__FLIGHT_RECORDER_H
+#define LIB_FSM__FLIGHT_RECORDER_H
+
+#include <cstdint>              // uint32_t
+#include <vector>               // std::vector
+#include <ostream>              // std::ostream
+#include <istream>              // std::istream
+
+#include "elements.h"           // element_id_t
+
+namespace fsm {
+
+class Process;
+
+// per-thread ring buffers of binary transition records, buffers are never freed to allow post-mortem dumps
+class FlightRecorder
+{
+public:
+
+    enum class event_type_e : uint32_t
+    {
+        UNDEF   = 0,
+        NEXT_STATE,
+        SIGNAL_HANDLER,
+        ACTION_CONNECTOR
+    };
+
+    struct Entry
+    {
+        uint64_t        timestamp;              // TSC
+        event_type_e    type;
+        uint32_t        process_id;
+        element_id_t    state_id;
+        element_id_t    signal_handler_id;
+        element_id_t    action_connector_id;
+        uint32_t        reserved;
+    };
+
+    struct Buffer;
+
+    static const unsigned   BUFFER_SIZE = 4096;    // number of entries per thread
+
+    static void set_enabled( bool is_enabled );
+    static bool is_enabled();
+
+    static void record(
+            event_type_e    type,
+            uint32_t        process_id,
+            element_id_t    state_id,
+            element_id_t    signal_handler_id,
+            element_id_t    action_connector_id );
+
+    static void dump( std::ostream & os );
+
+    // for crash handlers: uses only write(2) and doesn't wait for the registry mutex
+    static bool dump( int fd );
+
+    static bool load( std::vector<Entry> * entries, std::istream & is );
+
+    static std::ostream & write( std::ostream & os, const Entry & e, const Process & process );
+    static std::ostream & write( std::ostream & os, const std::vector<Entry> & entries, const Process & process );
+
+private:
+
+    static Buffer * get_buffer();
+    static uint64_t get_timestamp();
+};
+
+} // namespace fsm
+
+#endif // LIB_FSM__FLIGHT_RECORDER_H
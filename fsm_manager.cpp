@@ -19,37 +19,92 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-// $Revision: 10292 $ $Date:: 2018-12-20 #$ $Author: serge $
+// $Revision: 11676 $ $Date:: 2019-06-26 #$ $Author: serge $
 
 #include "fsm_manager.h"        // self
 
+#include <algorithm>            // std::max
 #include <cassert>              // assert
+#include <fstream>              // std::ifstream
 #include <typeindex>            // std::type_index
 #include <typeinfo>
 #include <unordered_map>
 
 #include "utils/dummy_logger.h"     // dummy_log_debug
 #include "utils/mutex_helper.h"     // MUTEX_SCOPE_LOCK
+#include "scheduler/timeout_job_aux.h"      // create_and_insert_timeout_job
+
+#include "serializer.h"             // Serializer
 
 namespace fsm {
 
+const uint32_t SNAPSHOT_MAGIC   = 0x534e5346;  // "FSNS"
+// 2 - definition version after the definition name
+const uint32_t SNAPSHOT_VERSION = 2;
+
+// ids of native processes don't overlap with the ones of interpreted processes
+const uint32_t NATIVE_PROCESS_ID_TAG    = 0x80000000;
+
 FsmManager::FsmManager():
         WorkerBase( this ),
         log_id_( 0 ),
         log_id_fsm_( 0 ),
         callback_( nullptr ),
-        scheduler_( nullptr )
+        scheduler_( nullptr ),
+        is_profiling_enabled_( false ),
+        is_exception_free_( false ),
+        num_failed_processes_( 0 ),
+        max_pool_size_( 0 ),
+        map_id_to_native_process_( NATIVE_PROCESS_ID_TAG ),
+        journal_max_delay_( 0 ),
+        journal_flush_job_id_( 0 ),
+        is_journal_flush_due_( false ),
+        lane_control_( 0 ),
+        lane_timer_( 0 ),
+        lane_signal_( 0 ),
+        is_create_process_refused_on_overload_( false ),
+        num_refused_processes_( 0 ),
+        is_overload_reported_( false ),
+        num_coalesced_signals_( 0 ),
+        num_dropped_merged_signals_( 0 ),
+        is_req_taken_( false )
 {
     req_id_gen_.init( 1, 1 );
 }
 
 FsmManager::~FsmManager()
 {
+    // the job refers to this object
+    cancel_journal_flush();
+
     for( auto & e : map_id_to_process_ )
     {
         delete e.second;
     }
 
+    for( auto & e : map_name_to_pool_ )
+    {
+        for( auto & p : e.second )
+        {
+            delete p;
+        }
+    }
+
+    for( auto & e : map_id_to_native_process_ )
+    {
+        delete e.second;
+    }
+
+    for( auto & e : map_key_to_latest_signal_ )
+    {
+        delete e.second;
+    }
+
+    for( auto & e : local_signals_ )
+    {
+        delete e;
+    }
+
     dummy_log_info( log_id_, "destructed" );
 }
 
@@ -68,6 +123,8 @@ bool FsmManager::init(
     log_id_     = log_id;
     log_id_fsm_ = log_id_fsm;
     callback_   = callback;
+
+    deferred_callback_.init( callback );
     scheduler_  = scheduler;
 
     dummy_log_info( log_id_, "init OK" );
@@ -77,7 +134,77 @@ bool FsmManager::init(
 
 void FsmManager::consume( const ev::Object * req )
 {
-    WorkerBase::consume( req );
+    std::string error_msg;
+
+    if( try_consume( req, & error_msg ) == false )
+    {
+        dummy_log_warn( log_id_, "event rejected: %s", error_msg.c_str() );
+    }
+}
+
+bool FsmManager::try_consume( const ev::Object * req, std::string * error_msg )
+{
+    if( coalesce( * req ) )
+        return true;
+
+    if( event_queue_ == nullptr )
+    {
+        WorkerBase::consume( req );
+        return true;
+    }
+
+    const ev::Object        * dropped;
+    EventQueue::watermark_e watermark;
+
+    if( event_queue_->push( get_lane( * req ), req, & dropped, & watermark ) == false )
+    {
+        * error_msg = "queue is full, depth " + std::to_string( event_queue_->get_depth() );
+
+        cancel_coalescing( * req );
+
+        release( req );
+
+        return false;
+    }
+
+    notify_watermark( watermark );
+
+    if( dropped )
+    {
+        log_dropped( * dropped );
+
+        cancel_coalescing( * dropped );
+
+        release( dropped );
+
+        // the token of the dropped event is taken over by the new one
+        return true;
+    }
+
+    WorkerBase::consume( & dequeue_token_ );
+
+    return true;
+}
+
+void FsmManager::log_dropped( const ev::Object & req ) const
+{
+    auto signal = dynamic_cast< const ev::Signal *>( & req );
+
+    if( signal )
+    {
+        dummy_log_warn( log_id_, "queue is full, dropped signal %s of process %u", signal->name.c_str(), signal->process_id );
+        return;
+    }
+
+    auto key_signal = dynamic_cast< const ev::KeySignal *>( & req );
+
+    if( key_signal )
+    {
+        dummy_log_warn( log_id_, "queue is full, dropped signal %s of correlation key %s", key_signal->signal.name.c_str(), key_signal->correlation_key.c_str() );
+        return;
+    }
+
+    dummy_log_warn( log_id_, "queue is full, dropped %s", typeid( req ).name() );
 }
 
 void FsmManager::start()
@@ -88,15 +215,33 @@ void FsmManager::start()
 void FsmManager::shutdown()
 {
     WorkerBase::shutdown();
+
+    if( journal_ )
+    {
+        cancel_journal_flush();
+
+        flush_journal();
+    }
 }
 
 uint32_t FsmManager::create_process()
 {
     MUTEX_SCOPE_LOCK( mutex_ );
 
-    auto id = req_id_gen_.get_next_request_id();
+    if( is_create_process_refused() )
+        return 0;
+
+    auto id = map_id_to_process_.get_next_id();
+
+    if( id == 0 )
+    {
+        dummy_log_error( log_id_, "cannot create process: too many processes" );
+        return 0;
+    }
 
-    auto fsm = new Process( id, log_id_fsm_, this, callback_, scheduler_ );
+    auto fsm = new Process( id, log_id_fsm_, this, & deferred_callback_, scheduler_ );
+
+    apply_options( fsm );
 
     dummy_log_info( log_id_, "new fsm %u", id );
 
@@ -104,156 +249,1762 @@ uint32_t FsmManager::create_process()
 
     assert( b );(void)b;
 
+    // the coalesced signals are added by the caller
+    update_coalescing( id, fsm );
+
     return id;
 }
 
-void FsmManager::start_process( uint32_t process_id )
+uint32_t FsmManager::register_definition( const std::string & name, const Definition::Initializer & initializer )
 {
-    dummy_log_info( log_id_, "start process %u", process_id );
+    MUTEX_SCOPE_LOCK( mutex_ );
 
-    consume( new ev::StartProcess( process_id ) );
+    return register_definition_intern( name, initializer )->version;
 }
 
-// must be called in the locked state
-Process* FsmManager::find_process( uint32_t process_id )
+uint32_t FsmManager::register_definition( const std::string & name, const Definition::Initializer & initializer, const NameMapper & mapper )
 {
-    auto it = map_id_to_process_.find( process_id );
+    MUTEX_SCOPE_LOCK( mutex_ );
 
-    if( it != map_id_to_process_.end() )
+    auto definition = register_definition_intern( name, initializer );
+
+    migrate_processes( definition, mapper );
+
+    return definition->version;
+}
+
+uint32_t FsmManager::create_process( const std::string & definition_name )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    return create_process_intern( definition_name, 0 );
+}
+
+uint32_t FsmManager::create_process( const std::string & definition_name, uint32_t parent_process_id )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    return create_process_intern( definition_name, parent_process_id );
+}
+
+uint32_t FsmManager::create_process( const std::string & definition_name, uint32_t parent_process_id, const std::string & correlation_key )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    if( map_key_to_process_id_.count( correlation_key ) )
     {
-        return it->second;
+        dummy_log_error( log_id_, "cannot create process: correlation key %s is in use", correlation_key.c_str() );
+        return 0;
     }
-    else
+
+    auto id = create_process_intern( definition_name, parent_process_id );
+
+    if( id != 0 )
     {
-        return nullptr;
+        set_correlation_key_intern( id, correlation_key );
     }
+
+    return id;
 }
 
-std::mutex & FsmManager::get_mutex() const
+bool FsmManager::set_correlation_key( uint32_t process_id, const std::string & correlation_key )
 {
-    return mutex_;
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    if( map_id_to_process_.count( process_id ) == 0 && map_id_to_native_process_.count( process_id ) == 0 )
+    {
+        dummy_log_error( log_id_, "process id %u: wrong process id or process ended", process_id );
+        return false;
+    }
+
+    return set_correlation_key_intern( process_id, correlation_key );
 }
 
-void FsmManager::handle( const ev::Object * req )
+bool FsmManager::set_correlation_key_intern( uint32_t process_id, const std::string & correlation_key )
 {
-    typedef FsmManager Type;
+    auto res = map_key_to_process_id_.insert( std::make_pair( correlation_key, process_id ) );
 
-    typedef void (Type::*PPMF)( const ev::Object & r );
+    if( res.second == false )
+    {
+        if( res.first->second == process_id )
+            return true;
 
-#define MAP_ENTRY(_v)       { typeid( ev:: _v ),        & Type::handle_##_v }
+        dummy_log_error( log_id_, "process id %u: correlation key %s is in use", process_id, correlation_key.c_str() );
+        return false;
+    }
 
-    static const std::unordered_map<std::type_index, PPMF> funcs =
+    // the previous key of the process is replaced
+    remove_correlation_key( process_id );
+
+    map_id_to_key_[ process_id ] = correlation_key;
+
+    return true;
+}
+
+uint32_t FsmManager::find_process_id( const std::string & correlation_key ) const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    auto it = map_key_to_process_id_.find( correlation_key );
+
+    if( it == map_key_to_process_id_.end() )
+        return 0;
+
+    return it->second;
+}
+
+uint32_t FsmManager::create_process_intern( const std::string & definition_name, uint32_t parent_process_id )
+{
+    if( is_create_process_refused() )
+        return 0;
+
+    auto it_native = map_name_to_native_factory_.find( definition_name );
+
+    if( it_native != map_name_to_native_factory_.end() )
     {
-        MAP_ENTRY( Signal ),
-        MAP_ENTRY( StartProcess ),
-        MAP_ENTRY( Timer ),
-    };
+        auto id = map_id_to_native_process_.get_next_id();
 
-#undef MAP_ENTRY
+        if( id == 0 )
+        {
+            dummy_log_error( log_id_, "cannot create process: too many native processes" );
+            return 0;
+        }
 
-    auto it = funcs.find( typeid( * req ) );
+        auto fsm = it_native->second( id, log_id_fsm_, this, callback_, scheduler_ );
 
-    if( it == funcs.end() )
+        dummy_log_info( log_id_, "new native fsm %u, definition %s", id, definition_name.c_str() );
+
+        auto b = map_id_to_native_process_.insert( std::make_pair( id, fsm ) ).second;
+
+        assert( b );(void)b;
+
+        return id;
+    }
+
+    auto it = map_name_to_definition_.find( definition_name );
+
+    if( it == map_name_to_definition_.end() )
     {
-        dummy_log_fatal( log_id_, "unsupported object %s", typeid( * req ).name() );
-        assert( 0 );
-        throw std::runtime_error( "unsupported object " + std::string( typeid( * req ).name() ) );
+        dummy_log_error( log_id_, "cannot create process: unknown definition %s", definition_name.c_str() );
+        return 0;
     }
 
-    (this->*it->second)( * req );
+    auto & definition = it->second;
 
-    release( req );
-}
+    auto id = map_id_to_process_.get_next_id();
 
-void FsmManager::handle_Signal( const ev::Object & rreq )
-{
-    auto & req = dynamic_cast< const ev::Signal &>( rreq );
+    if( id == 0 )
+    {
+        dummy_log_error( log_id_, "cannot create process: too many processes" );
+        return 0;
+    }
+
+    Process * fsm;
+
+    auto & pool = map_name_to_pool_[ definition_name ];
 
+    if( pool.empty() == false )
     {
-        MUTEX_SCOPE_LOCK( mutex_ );
+        // pooled processes always belong to the latest version, see release_process()
+        fsm = pool.back();
 
-        auto process_id = req.process_id;
+        pool.pop_back();
 
-        auto it = map_id_to_process_.find( process_id );
+        fsm->reset( id );
 
-        if( it != map_id_to_process_.end() )
-        {
-            it->second->handle( req );
+        dummy_log_info( log_id_, "reused fsm %u, definition %s v%u", id, definition->name.c_str(), definition->version );
+    }
+    else
+    {
+        // is freed if the initializer or the type check throws
+        std::unique_ptr<Process> new_fsm( new Process( id, log_id_fsm_, this, & deferred_callback_, scheduler_ ) );
 
-            check_process_end( it );
-        }
-        else
-        {
-            dummy_log_error( log_id_, "process id %u: wrong process id or process ended", process_id );
-        }
+        new_fsm->set_definition( definition );
+
+        definition->initializer( new_fsm.get() );
+
+        new_fsm->finalize();
+
+        fsm = new_fsm.release();
+
+        dummy_log_info( log_id_, "new fsm %u, definition %s v%u", id, definition->name.c_str(), definition->version );
     }
+
+    apply_options( fsm );
+
+    update_coalescing( id, fsm );
+
+    fsm->set_parent_process_id( parent_process_id );
+
+    auto b = map_id_to_process_.insert( std::make_pair( id, fsm ) ).second;
+
+    assert( b );(void)b;
+
+    return id;
 }
 
-void FsmManager::handle_StartProcess( const ev::Object & rreq )
+void FsmManager::register_native_definition( const std::string & name, const NativeProcess::Factory & factory )
 {
-    auto & req = dynamic_cast< const ev::StartProcess &>( rreq );
+    MUTEX_SCOPE_LOCK( mutex_ );
 
-    dummy_log_trace( log_id_, "handle %s, process id %u", typeid( req ).name(), req.process_id );
+    assert( factory );
 
-    {
-        MUTEX_SCOPE_LOCK( mutex_ );
+    map_name_to_native_factory_[ name ]  = factory;
 
-        auto process_id = req.process_id;
+    dummy_log_info( log_id_, "registered native definition %s", name.c_str() );
+}
 
-        auto it = map_id_to_process_.find( process_id );
+void FsmManager::set_profiling_enabled( bool is_enabled )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
 
-        if( it != map_id_to_process_.end() )
-        {
-            it->second->start();
+    is_profiling_enabled_   = is_enabled;
 
-            check_process_end( it );
-        }
-        else
-        {
-            dummy_log_error( log_id_, "process id %u: wrong process id or process ended", process_id );
-        }
+    for( auto & e : map_id_to_process_ )
+    {
+        apply_options( e.second );
     }
+
+    dummy_log_info( log_id_, "profiling %s", is_enabled ? "enabled" : "disabled" );
 }
 
-void FsmManager::handle_Timer( const ev::Object & rreq )
+bool FsmManager::get_profile( ExecutionProfile * profile, const std::string & definition_name ) const
 {
-    auto & req = dynamic_cast< const ev::Timer&>( rreq );
+    MUTEX_SCOPE_LOCK( mutex_ );
 
-    dummy_log_trace( log_id_, "handle %s, process id %u", typeid( req ).name(), req.process_id );
+    auto it = map_name_to_definition_.find( definition_name );
 
-    {
-        MUTEX_SCOPE_LOCK( mutex_ );
+    if( it == map_name_to_definition_.end() )
+        return false;
 
-        auto process_id = req.process_id;
+    * profile   = * it->second->profile;
 
-        auto it = map_id_to_process_.find( process_id );
+    return true;
+}
 
-        if( it != map_id_to_process_.end() )
-        {
-            it->second->handle( req );
+void FsmManager::clear_profile( const std::string & definition_name )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
 
-            check_process_end( it );
-        }
-        else
-        {
-            dummy_log_error( log_id_, "process id %u: wrong process id or process ended", process_id );
-        }
+    auto it = map_name_to_definition_.find( definition_name );
+
+    if( it != map_name_to_definition_.end() )
+    {
+        it->second->profile->clear();
     }
 }
 
-void FsmManager::release( const ev::Object * req ) const
+void FsmManager::set_exception_free( bool is_exception_free )
 {
-    delete req;
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    is_exception_free_  = is_exception_free;
+
+    for( auto & e : map_id_to_process_ )
+    {
+        apply_options( e.second );
+    }
+
+    dummy_log_info( log_id_, "exception-free mode %s", is_exception_free ? "enabled" : "disabled" );
 }
 
-void FsmManager::check_process_end( MapIdToProcess::iterator it )
+uint32_t FsmManager::get_num_failed_processes() const
 {
-    if( it->second->is_ended() )
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    return num_failed_processes_;
+}
+
+uint64_t FsmManager::get_num_coalesced_signals() const
+{
+    MUTEX_SCOPE_LOCK( coalescing_mutex_ );
+
+    return num_coalesced_signals_;
+}
+
+void FsmManager::set_max_pool_size( unsigned max_pool_size )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    max_pool_size_  = max_pool_size;
+
+    for( auto & e : map_name_to_pool_ )
     {
-        delete it->second;
+        auto & pool = e.second;
 
-        map_id_to_process_.erase( it );
+        while( pool.size() > max_pool_size_ )
+        {
+            delete pool.back();
+
+            pool.pop_back();
+        }
     }
+
+    dummy_log_info( log_id_, "max pool size %u", max_pool_size_ );
+}
+
+std::size_t FsmManager::get_memory_usage( uint32_t process_id ) const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    auto it = map_id_to_process_.find( process_id );
+
+    if( it == map_id_to_process_.end() )
+        return 0;
+
+    return it->second->get_memory_usage();
+}
+
+std::size_t FsmManager::get_definition_memory_usage( const std::string & definition_name ) const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    std::size_t res = 0;
+
+    for( auto & e : map_id_to_process_ )
+    {
+        auto & definition = e.second->get_definition();
+
+        if( definition && definition->name == definition_name )
+            res += e.second->get_memory_usage();
+    }
+
+    auto it = map_name_to_pool_.find( definition_name );
+
+    if( it != map_name_to_pool_.end() )
+    {
+        for( auto & p : it->second )
+        {
+            res += p->get_memory_usage();
+        }
+    }
+
+    return res;
+}
+
+std::size_t FsmManager::get_memory_usage() const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    std::size_t res = 0;
+
+    for( auto & e : map_id_to_process_ )
+    {
+        res += e.second->get_memory_usage();
+    }
+
+    for( auto & e : map_name_to_pool_ )
+    {
+        for( auto & p : e.second )
+        {
+            res += p->get_memory_usage();
+        }
+    }
+
+    return res;
+}
+
+void FsmManager::start_process( uint32_t process_id )
+{
+    dummy_log_info( log_id_, "start process %u", process_id );
+
+    consume( new ev::StartProcess( process_id ) );
+}
+
+// must be called in the locked state
+Process* FsmManager::find_process( uint32_t process_id )
+{
+    auto it = map_id_to_process_.find( process_id );
+
+    if( it != map_id_to_process_.end() )
+    {
+        return it->second;
+    }
+    else
+    {
+        return nullptr;
+    }
+}
+
+std::mutex & FsmManager::get_mutex() const
+{
+    return mutex_;
+}
+
+void FsmManager::save( std::ostream & os ) const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    uint32_t size = 0;
+
+    for( auto & e : map_id_to_process_ )
+    {
+        if( e.second->is_ended() == false )
+            ++size;
+    }
+
+    Serializer::save( os, SNAPSHOT_MAGIC );
+    Serializer::save( os, SNAPSHOT_VERSION );
+
+    save_generations( os, map_id_to_process_ );
+    save_generations( os, map_id_to_native_process_ );
+
+    Serializer::save( os, size );
+
+    for( auto & e : map_id_to_process_ )
+    {
+        if( e.second->is_ended() )
+            continue;
+
+        auto & definition = e.second->get_definition();
+
+        Serializer::save( os, e.first );
+        Serializer::save( os, definition ? definition->name : std::string() );
+        Serializer::save( os, definition ? definition->version : uint32_t( 0 ) );
+
+        e.second->save( os );
+    }
+
+    dummy_log_info( log_id_, "saved %u processes", size );
+
+    if( journal_ )
+    {
+        std::string error_msg;
+
+        // in the locked state, so that no record is appended between the snapshot and the rotation
+        if( journal_->rotate( & error_msg ) == false )
+        {
+            dummy_log_error( log_id_, "cannot rotate journal: %s", error_msg.c_str() );
+        }
+    }
+}
+
+bool FsmManager::load( std::istream & is, const ProcessInitializer & initializer, std::string * error_msg )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    if( map_id_to_process_.empty() == false )
+    {
+        * error_msg = "cannot load into non-empty manager";
+        return false;
+    }
+
+    uint32_t magic;
+    uint32_t version;
+
+    if( Serializer::load( & magic, is ) == false || Serializer::load( & version, is ) == false )
+    {
+        * error_msg = "cannot read snapshot header";
+        return false;
+    }
+
+    if( magic != SNAPSHOT_MAGIC )
+    {
+        * error_msg = "not a snapshot";
+        return false;
+    }
+
+    if( version != SNAPSHOT_VERSION )
+    {
+        * error_msg = "unsupported snapshot version " + std::to_string( version );
+        return false;
+    }
+
+    // native processes are not restored, but their ids are not reissued either
+    if( load_generations( & map_id_to_process_, is ) == false || load_generations( & map_id_to_native_process_, is ) == false )
+    {
+        * error_msg = "cannot read slot generations";
+        return false;
+    }
+
+    uint32_t size;
+
+    if( Serializer::load( & size, is ) == false )
+    {
+        * error_msg = "cannot read snapshot header";
+        return false;
+    }
+
+    uint32_t i      = 0;
+
+    for( ; i < size; ++i )
+    {
+        uint32_t    id;
+        std::string definition_name;
+        uint32_t    definition_version;
+
+        if( Serializer::load( & id, is ) == false
+                || Serializer::load( & definition_name, is ) == false
+                || Serializer::load( & definition_version, is ) == false )
+        {
+            * error_msg = "cannot read process id";
+            break;
+        }
+
+        auto fsm = new Process( id, log_id_fsm_, this, & deferred_callback_, scheduler_ );
+
+        auto b = map_id_to_process_.insert( std::make_pair( id, fsm ) ).second;
+
+        if( b == false )
+        {
+            delete fsm;
+            * error_msg = "invalid or duplicate process id " + std::to_string( id );
+            break;
+        }
+
+        if( init_restored_process( fsm, id, definition_name, definition_version, initializer ) == false )
+        {
+            // the half-restored process is removed at once, the table holds only initialized ones
+            map_id_to_process_.erase( map_id_to_process_.find( id ) );
+
+            update_coalescing( id, nullptr );
+
+            delete fsm;
+
+            * error_msg = "cannot initialize process " + std::to_string( id );
+            break;
+        }
+
+        if( fsm->load( is, error_msg ) == false )
+        {
+            * error_msg = "process " + std::to_string( id ) + ": " + * error_msg;
+            break;
+        }
+    }
+
+    if( i != size )
+    {
+        dummy_log_error( log_id_, "cannot load snapshot: %s", error_msg->c_str() );
+
+        for( auto & e : map_id_to_process_ )
+        {
+            update_coalescing( e.first, nullptr );
+
+            // a loaded process may have set its timers
+            e.second->reset_timers();
+
+            delete e.second;
+        }
+
+        map_id_to_process_.clear();
+
+        return false;
+    }
+
+    dummy_log_info( log_id_, "loaded %u processes", size );
+
+    return true;
+}
+
+template<class MAP>
+void FsmManager::save_generations( std::ostream & os, const MAP & map )
+{
+    auto generations = map.get_generations();
+
+    Serializer::save( os, uint32_t( generations.size() ) );
+
+    for( auto g : generations )
+        Serializer::save( os, g );
+}
+
+template<class MAP>
+bool FsmManager::load_generations( MAP * map, std::istream & is )
+{
+    uint32_t size;
+
+    if( Serializer::load( & size, is ) == false )
+        return false;
+
+    // checked before the allocation, the size comes from the input
+    if( size > MAP::INDEX_MASK + 1 )
+        return false;
+
+    std::vector<uint32_t> generations( size );
+
+    for( auto & g : generations )
+    {
+        if( Serializer::load( & g, is ) == false )
+            return false;
+    }
+
+    return map->set_generations( generations );
+}
+
+bool FsmManager::init_journal( const std::string & file_name, unsigned max_batch_size, double max_delay, std::string * error_msg )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    assert( journal_ == nullptr );
+
+    std::unique_ptr<Journal> journal( new Journal( log_id_ ) );
+
+    if( journal->init( file_name, max_batch_size, error_msg ) == false )
+        return false;
+
+    journal_            = std::move( journal );
+    journal_max_delay_  = scheduler::Duration( max_delay );
+
+    deferred_callback_.set_deferred( true );
+
+    return true;
+}
+
+bool FsmManager::init_priority_lanes( unsigned lane_control, unsigned lane_timer, unsigned lane_signal, const std::vector<unsigned> & max_bursts, std::string * error_msg )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    assert( event_queue_ == nullptr );
+
+    for( auto lane : { lane_control, lane_timer, lane_signal } )
+    {
+        if( lane >= max_bursts.size() )
+        {
+            * error_msg = "lane " + std::to_string( lane ) + " is out of range, number of lanes " + std::to_string( max_bursts.size() );
+            return false;
+        }
+    }
+
+    std::unique_ptr<EventQueue> event_queue( new EventQueue );
+
+    if( event_queue->init( max_bursts, error_msg ) == false )
+        return false;
+
+    event_queue_    = std::move( event_queue );
+    lane_control_   = lane_control;
+    lane_timer_     = lane_timer;
+    lane_signal_    = lane_signal;
+
+    dummy_log_info( log_id_, "priority lanes: control %u, timer %u, signal %u, number of lanes %u",
+            lane_control, lane_timer, lane_signal, unsigned( max_bursts.size() ) );
+
+    return true;
+}
+
+void FsmManager::get_lane_stats( std::vector<EventQueue::LaneStats> * stats ) const
+{
+    if( event_queue_ == nullptr )
+    {
+        stats->clear();
+        return;
+    }
+
+    event_queue_->get_stats( stats );
+}
+
+bool FsmManager::init_admission_control(
+        unsigned                            max_depth,
+        unsigned                            high_watermark,
+        unsigned                            low_watermark,
+        EventQueue::overload_policy_e       policy,
+        bool                                refuse_create_process,
+        std::string                         * error_msg )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    std::unique_ptr<EventQueue> event_queue;
+
+    auto queue = event_queue_.get();
+
+    if( queue == nullptr )
+    {
+        // a single lane for all events
+        event_queue.reset( new EventQueue );
+
+        if( event_queue->init( { 0 }, error_msg ) == false )
+            return false;
+
+        queue   = event_queue.get();
+    }
+
+    auto is_sheddable = []( const ev::Object & req ) { return typeid( req ) == typeid( ev::Signal ) || typeid( req ) == typeid( ev::KeySignal ); };
+
+    if( queue->init_limit( max_depth, high_watermark, low_watermark, policy, is_sheddable, error_msg ) == false )
+        return false;
+
+    if( event_queue )
+    {
+        event_queue_    = std::move( event_queue );
+    }
+
+    is_create_process_refused_on_overload_  = refuse_create_process;
+
+    dummy_log_info( log_id_, "admission control: max depth %u, watermarks %u/%u, policy %s, refuse create process %u",
+            max_depth, high_watermark, low_watermark,
+            ( policy == EventQueue::overload_policy_e::REJECT ) ? "REJECT" : "DROP_OLDEST", unsigned( refuse_create_process ) );
+
+    return true;
+}
+
+void FsmManager::get_admission_stats( AdmissionStats * stats ) const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    EventQueue::LimitStats limit_stats = { 0, 0, 0 };
+
+    if( event_queue_ )
+    {
+        event_queue_->get_limit_stats( & limit_stats );
+    }
+
+    stats->num_rejected             = limit_stats.num_rejected;
+    stats->num_dropped              = limit_stats.num_dropped;
+    stats->num_refused_processes    = num_refused_processes_;
+    stats->num_overloads            = limit_stats.num_overloads;
+
+    {
+        MUTEX_SCOPE_LOCK( coalescing_mutex_ );
+
+        stats->num_dropped          += num_dropped_merged_signals_;
+    }
+}
+
+bool FsmManager::replay_journal( const std::string & file_name, const ProcessInitializer & initializer, std::string * error_msg )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    std::ifstream is( file_name, std::ios::binary );
+
+    if( ! is )
+    {
+        * error_msg = "cannot open journal " + file_name;
+        return false;
+    }
+
+    if( Journal::read_header( is, error_msg ) == false )
+    {
+        * error_msg = file_name + ": " + * error_msg;
+        return false;
+    }
+
+    unsigned num_records = 0;
+
+    std::string record;
+
+    while( Journal::read_record( & record, is ) )
+    {
+        std::istringstream rs( record );
+
+        uint32_t    process_id;
+        uint8_t     type;
+        std::string definition_name;
+        uint32_t    definition_version  = 0;
+
+        if( Serializer::load( & process_id, rs ) == false
+                || Serializer::load( & type, rs ) == false
+                || read_journal_event( & definition_name, & definition_version, journal_event_type_e( type ), rs ) == false )
+        {
+            * error_msg = "record " + std::to_string( num_records ) + ": cannot read event";
+            return false;
+        }
+
+        auto it = map_id_to_process_.find( process_id );
+
+        if( it == map_id_to_process_.end() )
+        {
+            // process was created after the snapshot
+
+            auto fsm = new Process( process_id, log_id_fsm_, this, & deferred_callback_, scheduler_ );
+
+            auto res = map_id_to_process_.insert( std::make_pair( process_id, fsm ) );
+
+            if( res.second == false )
+            {
+                delete fsm;
+                * error_msg = "record " + std::to_string( num_records ) + ": invalid process id " + std::to_string( process_id );
+                return false;
+            }
+
+            it = res.first;
+
+            if( init_restored_process( fsm, process_id, definition_name, definition_version, initializer ) == false )
+            {
+                map_id_to_process_.erase( it );
+
+                update_coalescing( process_id, nullptr );
+
+                delete fsm;
+
+                * error_msg = "cannot initialize process " + std::to_string( process_id );
+                return false;
+            }
+        }
+
+        if( it->second->load_delta( rs, error_msg ) == false )
+        {
+            * error_msg = "record " + std::to_string( num_records ) + ": process " + std::to_string( process_id ) + ": " + * error_msg;
+            return false;
+        }
+
+        check_process_end( it );
+
+        ++num_records;
+    }
+
+    dummy_log_info( log_id_, "replayed %u journal records, %u processes", num_records, unsigned( map_id_to_process_.size() ) );
+
+    return true;
+}
+
+void FsmManager::handle( const ev::Object * req )
+{
+    if( req == & dequeue_token_ )
+    {
+        EventQueue::watermark_e watermark;
+
+        req = event_queue_->pop( & watermark );
+
+        assert( req );  // one token per queued event
+
+        notify_watermark( watermark );
+    }
+
+    typedef FsmManager Type;
+
+    typedef void (Type::*PPMF)( const ev::Object & r );
+
+#define MAP_ENTRY(_v)       { typeid( ev:: _v ),        & Type::handle_##_v }
+
+    static const std::unordered_map<std::type_index, PPMF> funcs =
+    {
+        MAP_ENTRY( Signal ),
+        MAP_ENTRY( StartProcess ),
+        MAP_ENTRY( Timer ),
+        MAP_ENTRY( FlushJournal ),
+        MAP_ENTRY( Broadcast ),
+        MAP_ENTRY( KeySignal ),
+    };
+
+#undef MAP_ENTRY
+
+    auto it = funcs.find( typeid( * req ) );
+
+    if( it == funcs.end() )
+    {
+        dummy_log_fatal( log_id_, "unsupported object %s", typeid( * req ).name() );
+        assert( 0 );
+        throw std::runtime_error( "unsupported object " + std::string( typeid( * req ).name() ) );
+    }
+
+    is_req_taken_   = false;
+
+    (this->*it->second)( * req );
+
+    if( is_req_taken_ == false )
+    {
+        release( req );
+    }
+
+    handle_local_signals();
+
+    // a full batch is synced unlocked, processes may go on meanwhile
+    if( journal_ && ( is_journal_flush_due_ || journal_->is_flush_needed() ) )
+    {
+        is_journal_flush_due_   = false;
+
+        flush_journal();
+    }
+}
+
+void FsmManager::handle_Signal( const ev::Object & rreq )
+{
+    std::unique_ptr<const ev::Signal> latest;
+
+    auto & req = take_latest_signal( dynamic_cast< const ev::Signal &>( rreq ), & latest );
+
+    bool is_saved;
+
+    {
+        MUTEX_SCOPE_LOCK( mutex_ );
+
+        is_saved = deliver_signal( req );
+    }
+
+    if( is_saved )
+    {
+        // the process owns the saved signal
+        if( latest )
+            latest.release();
+        else
+            is_req_taken_   = true;
+    }
+}
+
+bool FsmManager::deliver_signal( const ev::Signal & req )
+{
+    auto process_id = req.process_id;
+
+    auto it = map_id_to_process_.find( process_id );
+
+    if( it != map_id_to_process_.end() )
+    {
+        return deliver_signal( it, req, false );
+    }
+
+    if( handle_native_process( process_id, [&req]( NativeProcess * process ) { process->handle( req ); } ) == false )
+    {
+        dummy_log_error( log_id_, "process id %u: wrong process id or process ended", process_id );
+    }
+
+    return false;
+}
+
+bool FsmManager::deliver_signal( MapIdToProcess::iterator it, const ev::Signal & req, bool is_shared )
+{
+    auto process_id = it->first;
+
+    auto is_saved = false;
+
+    if( is_shared )
+        execute_process( it->second, [&req]( Process * process ) { process->handle_shared( req ); } );
+    else
+        execute_process( it->second, [&req, &is_saved]( Process * process ) { is_saved = process->handle( req ); } );
+
+    if( journal_ )
+    {
+        begin_journal_record( journal_event_type_e::SIGNAL, process_id );
+
+        Serializer::save( journal_record_, req.name );
+        Serializer::save( journal_record_, uint32_t( req.arguments.size() ) );
+
+        for( auto & e : req.arguments )
+        {
+            Serializer::save( journal_record_, e );
+        }
+
+        end_journal_record( it->second );
+    }
+
+    check_process_end( it );
+
+    return is_saved;
+}
+
+void FsmManager::deliver_shared_signal( uint32_t process_id, const ev::Signal & req )
+{
+    auto it = map_id_to_process_.find( process_id );
+
+    if( it != map_id_to_process_.end() )
+    {
+        deliver_signal( it, req, true );
+    }
+    else
+    {
+        handle_native_process( process_id, [&req]( NativeProcess * process ) { process->handle( req ); } );
+    }
+}
+
+void FsmManager::handle_Broadcast( const ev::Object & rreq )
+{
+    auto & req = dynamic_cast< const ev::Broadcast &>( rreq );
+
+    dummy_log_trace( log_id_, "handle %s, signal %s, target %s", typeid( req ).name(), req.signal.name.c_str(), req.target_name.c_str() );
+
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    if( req.target == ev::Broadcast::target_e::GROUP )
+    {
+        auto it = map_name_to_group_.find( req.target_name );
+
+        if( it == map_name_to_group_.end() )
+        {
+            dummy_log_info( log_id_, "group %s is empty, ignoring", req.target_name.c_str() );
+            return;
+        }
+
+        // the group is erased when its last process ends
+        std::vector<uint32_t> process_ids( it->second.begin(), it->second.end() );
+
+        for( auto process_id : process_ids )
+        {
+            deliver_shared_signal( process_id, req.signal );
+        }
+
+        return;
+    }
+
+    // an ended process is erased, so the next one is taken before
+    for( auto it = map_id_to_process_.begin(); it != map_id_to_process_.end(); )
+    {
+        auto curr = it++;
+
+        if( req.target == ev::Broadcast::target_e::DEFINITION )
+        {
+            auto & definition = curr->second->get_definition();
+
+            if( definition == nullptr || definition->name != req.target_name )
+                continue;
+        }
+
+        deliver_signal( curr, req.signal, true );
+    }
+
+    // native processes don't keep the name of their definition
+    if( req.target == ev::Broadcast::target_e::DEFINITION )
+        return;
+
+    for( auto it = map_id_to_native_process_.begin(); it != map_id_to_native_process_.end(); )
+    {
+        auto process_id = it->first;
+
+        ++it;
+
+        handle_native_process( process_id, [&req]( NativeProcess * process ) { process->handle( req.signal ); } );
+    }
+}
+
+void FsmManager::send_signal( uint32_t process_id, const std::string & name, std::vector<Value> && arguments )
+{
+    // is called in the locked state by a process handled in the worker thread
+    local_signals_.push_back( new ev::Signal( process_id, name, std::move( arguments ) ) );
+}
+
+bool FsmManager::join_group( uint32_t process_id, const std::string & group_name )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    if( map_id_to_process_.count( process_id ) == 0 && map_id_to_native_process_.count( process_id ) == 0 )
+    {
+        dummy_log_error( log_id_, "process id %u: wrong process id or process ended", process_id );
+        return false;
+    }
+
+    map_name_to_group_[ group_name ].insert( process_id );
+    map_id_to_group_names_[ process_id ].insert( group_name );
+
+    return true;
+}
+
+void FsmManager::leave_group( uint32_t process_id, const std::string & group_name )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    auto it = map_id_to_group_names_.find( process_id );
+
+    if( it == map_id_to_group_names_.end() || it->second.erase( group_name ) == 0 )
+        return;
+
+    if( it->second.empty() )
+        map_id_to_group_names_.erase( it );
+
+    auto it_group = map_name_to_group_.find( group_name );
+
+    it_group->second.erase( process_id );
+
+    if( it_group->second.empty() )
+        map_name_to_group_.erase( it_group );
+}
+
+void FsmManager::handle_KeySignal( const ev::Object & rreq )
+{
+    auto & req = dynamic_cast< const ev::KeySignal &>( rreq );
+
+    dummy_log_trace( log_id_, "handle %s, signal %s, key %s", typeid( req ).name(), req.signal.name.c_str(), req.correlation_key.c_str() );
+
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    auto it = map_key_to_process_id_.find( req.correlation_key );
+
+    if( it == map_key_to_process_id_.end() )
+    {
+        dummy_log_error( log_id_, "correlation key %s: unknown key or process ended", req.correlation_key.c_str() );
+        return;
+    }
+
+    // the signal is part of the event, so a saved one is copied
+    deliver_shared_signal( it->second, req.signal );
+}
+
+void FsmManager::handle_local_signals()
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    // signals sent while handling a local signal are appended
+    while( local_signals_.empty() == false )
+    {
+        std::unique_ptr<const ev::Signal> req( local_signals_.front() );
+
+        local_signals_.pop_front();
+
+        if( deliver_signal( * req ) )
+        {
+            // the process owns the saved signal
+            req.release();
+        }
+    }
+}
+
+void FsmManager::handle_StartProcess( const ev::Object & rreq )
+{
+    auto & req = dynamic_cast< const ev::StartProcess &>( rreq );
+
+    dummy_log_trace( log_id_, "handle %s, process id %u", typeid( req ).name(), req.process_id );
+
+    {
+        MUTEX_SCOPE_LOCK( mutex_ );
+
+        auto process_id = req.process_id;
+
+        auto it = map_id_to_process_.find( process_id );
+
+        if( it != map_id_to_process_.end() )
+        {
+            execute_process( it->second, []( Process * process ) { process->start(); } );
+
+            if( journal_ )
+            {
+                auto & definition = it->second->get_definition();
+
+                begin_journal_record( journal_event_type_e::START_PROCESS, process_id );
+
+                Serializer::save( journal_record_, definition ? definition->name : std::string() );
+                Serializer::save( journal_record_, definition ? definition->version : uint32_t( 0 ) );
+
+                end_journal_record( it->second );
+            }
+
+            check_process_end( it );
+        }
+        else if( handle_native_process( process_id, []( NativeProcess * process ) { process->start(); } ) == false )
+        {
+            dummy_log_error( log_id_, "process id %u: wrong process id or process ended", process_id );
+        }
+    }
+}
+
+void FsmManager::handle_Timer( const ev::Object & rreq )
+{
+    auto & req = dynamic_cast< const ev::Timer&>( rreq );
+
+    dummy_log_trace( log_id_, "handle %s, process id %u", typeid( req ).name(), req.process_id );
+
+    {
+        MUTEX_SCOPE_LOCK( mutex_ );
+
+        auto process_id = req.process_id;
+
+        auto it = map_id_to_process_.find( process_id );
+
+        if( it != map_id_to_process_.end() )
+        {
+            execute_process( it->second, [&req]( Process * process ) { process->handle( req ); } );
+
+            if( journal_ )
+            {
+                begin_journal_record( journal_event_type_e::TIMER, process_id );
+
+                Serializer::save( journal_record_, uint32_t( req.timer_id ) );
+
+                end_journal_record( it->second );
+            }
+
+            check_process_end( it );
+        }
+        else if( handle_native_process( process_id, [&req]( NativeProcess * process ) { process->handle( req ); } ) == false )
+        {
+            dummy_log_error( log_id_, "process id %u: wrong process id or process ended", process_id );
+        }
+    }
+}
+
+void FsmManager::handle_FlushJournal( const ev::Object & /* rreq */ )
+{
+    {
+        MUTEX_SCOPE_LOCK( mutex_ );
+
+        journal_flush_job_id_   = 0;
+    }
+
+    // the batch is taken over by the journal, processes append to the next one while it is synced
+    if( journal_ )
+    {
+        flush_journal();
+    }
+}
+
+void FsmManager::release( const ev::Object * req ) const
+{
+    if( req == & dequeue_token_ )
+        return;
+
+    delete req;
+}
+
+unsigned FsmManager::get_lane( const ev::Object & req ) const
+{
+    if( typeid( req ) == typeid( ev::Signal ) || typeid( req ) == typeid( ev::Broadcast ) || typeid( req ) == typeid( ev::KeySignal ) )
+        return lane_signal_;
+
+    if( typeid( req ) == typeid( ev::Timer ) )
+        return lane_timer_;
+
+    return lane_control_;
+}
+
+void FsmManager::notify_watermark( EventQueue::watermark_e watermark )
+{
+    if( watermark == EventQueue::watermark_e::NONE )
+        return;
+
+    // HIGH is reported by the producer and LOW by the worker after the queue is unlocked, so a LOW may come before its HIGH,
+    // the current state of the queue is reported instead, if it differs from the last reported one
+    MUTEX_SCOPE_LOCK( watermark_mutex_ );
+
+    auto is_overloaded  = event_queue_->is_overloaded();
+
+    if( is_overloaded == is_overload_reported_ )
+        return;
+
+    is_overload_reported_   = is_overloaded;
+
+    auto depth          = event_queue_->get_depth();
+
+    dummy_log_warn( log_id_, "%s watermark reached, queue depth %u", is_overloaded ? "high" : "low", unsigned( depth ) );
+
+    callback_->handle_overload( is_overloaded, depth );
+}
+
+bool FsmManager::coalesce( const ev::Object & req )
+{
+    if( typeid( req ) != typeid( ev::Signal ) )
+        return false;
+
+    auto & signal = static_cast< const ev::Signal &>( req );
+
+    MUTEX_SCOPE_LOCK( coalescing_mutex_ );
+
+    auto it = map_id_to_coalesced_signals_.find( signal.process_id );
+
+    if( it == map_id_to_coalesced_signals_.end() || it->second->count( signal.name ) == 0 )
+        return false;
+
+    auto key = std::make_pair( signal.process_id, signal.name );
+
+    auto it_latest = map_key_to_latest_signal_.find( key );
+
+    if( it_latest == map_key_to_latest_signal_.end() )
+    {
+        // the first signal is queued, the following ones are merged into it
+        map_key_to_latest_signal_.insert( std::make_pair( key, nullptr ) );
+        return false;
+    }
+
+    delete it_latest->second;
+
+    it_latest->second   = & signal;
+
+    ++num_coalesced_signals_;
+
+    return true;
+}
+
+void FsmManager::cancel_coalescing( const ev::Object & req )
+{
+    if( typeid( req ) != typeid( ev::Signal ) )
+        return;
+
+    auto & signal = static_cast< const ev::Signal &>( req );
+
+    MUTEX_SCOPE_LOCK( coalescing_mutex_ );
+
+    auto it = map_key_to_latest_signal_.find( std::make_pair( signal.process_id, signal.name ) );
+
+    if( it == map_key_to_latest_signal_.end() )
+        return;
+
+    if( it->second )
+    {
+        // the merged signal is dropped along with the queued one
+        ++num_dropped_merged_signals_;
+
+        delete it->second;
+    }
+
+    map_key_to_latest_signal_.erase( it );
+}
+
+const ev::Signal & FsmManager::take_latest_signal( const ev::Signal & req, std::unique_ptr<const ev::Signal> * latest )
+{
+    MUTEX_SCOPE_LOCK( coalescing_mutex_ );
+
+    if( map_key_to_latest_signal_.empty() )
+        return req;
+
+    auto it = map_key_to_latest_signal_.find( std::make_pair( req.process_id, req.name ) );
+
+    if( it == map_key_to_latest_signal_.end() )
+        return req;
+
+    latest->reset( it->second );
+
+    map_key_to_latest_signal_.erase( it );
+
+    if( * latest == nullptr )
+        return req;
+
+    dummy_log_debug( log_id_, "process id %u: signal %s replaced by the latest one", req.process_id, req.name.c_str() );
+
+    return ** latest;
+}
+
+void FsmManager::update_coalescing( uint32_t process_id, const Process * process )
+{
+    MUTEX_SCOPE_LOCK( coalescing_mutex_ );
+
+    // signals queued for the process are still merged into, they are released by take_latest_signal(),
+    // the set is registered even if it is empty, it may be filled after the process was created
+    if( process == nullptr )
+    {
+        map_id_to_coalesced_signals_.erase( process_id );
+        return;
+    }
+
+    map_id_to_coalesced_signals_[ process_id ]  = & process->get_coalesced_signals();
+}
+
+bool FsmManager::is_create_process_refused()
+{
+    if( is_create_process_refused_on_overload_ == false || event_queue_->is_overloaded() == false )
+        return false;
+
+    ++num_refused_processes_;
+
+    dummy_log_warn( log_id_, "cannot create process: overloaded" );
+
+    return true;
+}
+
+void FsmManager::check_process_end( MapIdToProcess::iterator it )
+{
+    if( it->second->is_ended() )
+    {
+        if( it->second->has_error() )
+        {
+            report_process_error( it->first, it->second->get_error() );
+        }
+
+        update_coalescing( it->first, nullptr );
+
+        leave_groups( it->first );
+
+        remove_correlation_key( it->first );
+
+        release_process( it->second );
+
+        map_id_to_process_.erase( it );
+    }
+}
+
+void FsmManager::check_process_end( MapIdToNativeProcess::iterator it )
+{
+    if( it->second->is_ended() )
+    {
+        leave_groups( it->first );
+
+        remove_correlation_key( it->first );
+
+        delete it->second;
+
+        map_id_to_native_process_.erase( it );
+    }
+}
+
+void FsmManager::leave_groups( uint32_t process_id )
+{
+    auto it = map_id_to_group_names_.find( process_id );
+
+    if( it == map_id_to_group_names_.end() )
+        return;
+
+    for( auto & group_name : it->second )
+    {
+        auto it_group = map_name_to_group_.find( group_name );
+
+        it_group->second.erase( process_id );
+
+        if( it_group->second.empty() )
+            map_name_to_group_.erase( it_group );
+    }
+
+    map_id_to_group_names_.erase( it );
+}
+
+void FsmManager::remove_correlation_key( uint32_t process_id )
+{
+    auto it = map_id_to_key_.find( process_id );
+
+    if( it == map_id_to_key_.end() )
+        return;
+
+    map_key_to_process_id_.erase( it->second );
+
+    map_id_to_key_.erase( it );
+}
+
+bool FsmManager::handle_native_process( uint32_t process_id, const std::function<void( NativeProcess * process )> & handler )
+{
+    auto it = map_id_to_native_process_.find( process_id );
+
+    if( it == map_id_to_native_process_.end() )
+        return false;
+
+    if( is_exception_free_ == false )
+    {
+        handler( it->second );
+    }
+    else
+    {
+        try
+        {
+            handler( it->second );
+        }
+        catch( std::exception & e )
+        {
+            report_process_error( process_id, e.what() );
+
+            leave_groups( process_id );
+
+            remove_correlation_key( process_id );
+
+            delete it->second;
+
+            map_id_to_native_process_.erase( it );
+
+            return true;
+        }
+    }
+
+    check_process_end( it );
+
+    return true;
+}
+
+void FsmManager::execute_process( Process * process, const std::function<void( Process * process )> & handler )
+{
+    if( is_exception_free_ == false )
+    {
+        handler( process );
+        return;
+    }
+
+    try
+    {
+        handler( process );
+    }
+    catch( std::exception & e )
+    {
+        process->terminate( e.what() );
+    }
+}
+
+void FsmManager::report_process_error( uint32_t process_id, const std::string & error )
+{
+    ++num_failed_processes_;
+
+    dummy_log_error( log_id_, "process id %u: terminated by error: %s", process_id, error.c_str() );
+
+    callback_->handle_process_error( process_id, error );
+}
+
+void FsmManager::release_process( Process * process )
+{
+    // a pooled process keeps its timers until it is reused
+    process->reset_timers();
+
+    auto & definition = process->get_definition();
+
+    // a failed process is not reused
+    if( definition == nullptr || max_pool_size_ == 0 || process->has_error() )
+    {
+        delete process;
+        return;
+    }
+
+    auto it = map_name_to_definition_.find( definition->name );
+
+    // instances of previous versions are not reused
+    if( it == map_name_to_definition_.end() || it->second != definition )
+    {
+        delete process;
+        return;
+    }
+
+    auto & pool = map_name_to_pool_[ definition->name ];
+
+    if( pool.size() >= max_pool_size_ )
+    {
+        delete process;
+        return;
+    }
+
+    pool.push_back( process );
+}
+
+void FsmManager::apply_options( Process * process )
+{
+    process->set_exception_free( is_exception_free_ );
+
+    auto & definition = process->get_definition();
+
+    // a process without definition keeps the profile set by the user
+    if( definition == nullptr )
+        return;
+
+    process->set_profile( is_profiling_enabled_ ? definition->profile.get() : nullptr );
+}
+
+void FsmManager::clear_pool( const std::string & definition_name )
+{
+    auto it = map_name_to_pool_.find( definition_name );
+
+    if( it == map_name_to_pool_.end() )
+        return;
+
+    for( auto & p : it->second )
+    {
+        delete p;
+    }
+
+    map_name_to_pool_.erase( it );
+}
+
+void FsmManager::begin_journal_record( journal_event_type_e type, uint32_t process_id )
+{
+    journal_record_.str( std::string() );
+
+    Serializer::save( journal_record_, process_id );
+    Serializer::save( journal_record_, uint8_t( type ) );
+}
+
+void FsmManager::end_journal_record( Process * process )
+{
+    process->save_delta( journal_record_ );
+
+    auto is_first = journal_->append( journal_record_.str() );
+
+    // the signals sent in the transition are held until the record is synced
+    deferred_callback_.commit( journal_->get_num_records() );
+
+    // a full batch is flushed by handle() after the event
+    if( is_first && journal_->is_flush_needed() == false )
+    {
+        schedule_journal_flush();
+    }
+}
+
+void FsmManager::schedule_journal_flush()
+{
+    std::string error_msg;
+
+    scheduler::job_id_t job_id;
+
+    auto b = scheduler::create_and_insert_timeout_job(
+            & job_id,
+            & error_msg,
+            * scheduler_,
+            "journal_flush",
+            journal_max_delay_,
+            [this]() { consume( new ev::FlushJournal ); } );
+
+    if( b == false )
+    {
+        dummy_log_error( log_id_, "cannot schedule journal flush: %s, flushing after the event", error_msg.c_str() );
+
+        is_journal_flush_due_   = true;
+
+        return;
+    }
+
+    journal_flush_job_id_   = job_id;
+}
+
+void FsmManager::cancel_journal_flush()
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    if( journal_flush_job_id_ == 0 )
+        return;
+
+    std::string error_msg;
+
+    if( scheduler_->delete_job( & error_msg, journal_flush_job_id_ ) == false )
+    {
+        dummy_log_warn( log_id_, "cannot cancel journal flush: %s", error_msg.c_str() );
+    }
+
+    journal_flush_job_id_   = 0;
+}
+
+void FsmManager::flush_journal()
+{
+    if( journal_->flush() == false )
+    {
+        // the signals are kept, the batch is retried by the next flush
+        return;
+    }
+
+    deferred_callback_.release( journal_->get_num_durable_records() );
+}
+
+bool FsmManager::read_journal_event( std::string * definition_name, uint32_t * definition_version, journal_event_type_e type, std::istream & is )
+{
+    switch( type )
+    {
+    case journal_event_type_e::SIGNAL:
+    {
+        std::string name;
+        uint32_t    size;
+
+        if( Serializer::load( & name, is ) == false || Serializer::load( & size, is ) == false )
+            return false;
+
+        if( size > Serializer::MAX_NUM_ARGUMENTS )
+            return false;
+
+        for( uint32_t i = 0; i < size; ++i )
+        {
+            Value v;
+
+            if( Serializer::load( & v, is ) == false )
+                return false;
+        }
+
+        return true;
+    }
+
+    case journal_event_type_e::TIMER:
+    {
+        uint32_t timer_id;
+
+        return Serializer::load( & timer_id, is );
+    }
+
+    case journal_event_type_e::START_PROCESS:
+        return Serializer::load( definition_name, is ) && Serializer::load( definition_version, is );
+
+    default:
+        return false;
+    }
+}
+
+DefinitionPtr FsmManager::register_definition_intern( const std::string & name, const Definition::Initializer & initializer )
+{
+    auto & definition = map_name_to_definition_[ name ];
+
+    auto version = definition ? definition->version + 1 : 1;
+
+    // the previous version stays alive as long as it has instances
+    definition = std::make_shared<Definition>( name, version, initializer );
+
+    // pooled processes hold the previous version
+    clear_pool( name );
+
+    dummy_log_info( log_id_, "registered definition %s v%u", name.c_str(), version );
+
+    return definition;
+}
+
+void FsmManager::migrate_processes( const DefinitionPtr & definition, const NameMapper & mapper )
+{
+    unsigned num_migrated   = 0;
+    unsigned num_failed     = 0;
+
+    for( auto & e : map_id_to_process_ )
+    {
+        auto old_fsm = e.second;
+
+        auto & old_definition = old_fsm->get_definition();
+
+        if( old_definition == nullptr || old_definition->name != definition->name || old_definition == definition || old_fsm->is_ended() )
+            continue;
+
+        auto fsm = new Process( e.first, log_id_fsm_, this, & deferred_callback_, scheduler_ );
+
+        fsm->set_definition( definition );
+
+        fsm->set_parent_process_id( old_fsm->get_parent_process_id() );
+
+        // timer events of the old process may be queued, they are ignored by the new one
+        fsm->set_epoch( old_fsm->get_epoch() + 1 );
+
+        definition->initializer( fsm );
+
+        fsm->finalize();
+
+        apply_options( fsm );
+
+        // signals deferred by SAVE are copied too, the ones of the old process are deleted with it
+        std::stringstream ss;
+
+        old_fsm->save( ss );
+
+        std::string error_msg;
+
+        if( fsm->load( ss, mapper, & error_msg ) == false )
+        {
+            dummy_log_error( log_id_, "process id %u: cannot migrate to %s v%u: %s, remains on v%u",
+                    e.first, definition->name.c_str(), definition->version, error_msg.c_str(), old_definition->version );
+
+            fsm->reset_timers();
+
+            delete fsm;
+
+            ++num_failed;
+
+            continue;
+        }
+
+        old_fsm->reset_timers();
+
+        update_coalescing( e.first, fsm );
+
+        delete old_fsm;
+
+        e.second = fsm;
+
+        ++num_migrated;
+    }
+
+    dummy_log_info( log_id_, "definition %s v%u: migrated %u processes, failed %u", definition->name.c_str(), definition->version, num_migrated, num_failed );
+}
+
+bool FsmManager::init_restored_process( Process * process, uint32_t process_id, const std::string & definition_name, uint32_t definition_version, const ProcessInitializer & initializer )
+{
+    if( definition_name.empty() == false )
+    {
+        auto it = map_name_to_definition_.find( definition_name );
+
+        if( it != map_name_to_definition_.end() )
+        {
+            if( it->second->version != definition_version )
+            {
+                dummy_log_warn( log_id_, "process id %u: saved with %s v%u, restored with v%u",
+                        process_id, definition_name.c_str(), definition_version, it->second->version );
+            }
+
+            process->set_definition( it->second );
+
+            it->second->initializer( process );
+
+            process->finalize();
+
+            apply_options( process );
+
+            update_coalescing( process_id, process );
+
+            return true;
+        }
+    }
+
+    if( ! initializer || initializer( process_id, process ) == false )
+        return false;
+
+    process->finalize();
+
+    apply_options( process );
+
+    update_coalescing( process_id, process );
+
+    return true;
 }
 
 element_id_t FsmManager::get_next_id()
@@ -19,13 +19,20 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-// $Revision: 10290 $ $Date:: 2018-12-20 #$ $Author: serge $
+// $Revision: 11676 $ $Date:: 2019-06-26 #$ $Author: serge $
 
 #ifndef LIB_FSM__FSM_MANAGER_H
 #define LIB_FSM__FSM_MANAGER_H
 
+#include <deque>                // std::deque
 #include <map>                  // std::map
+#include <set>                  // std::set
+#include <unordered_map>        // std::unordered_map
 #include <mutex>                // std::mutex
+#include <functional>           // std::function
+#include <memory>               // std::unique_ptr
+#include <sstream>              // std::ostringstream
+#include <vector>               // std::vector
 
 #include "workt/worker_t.h"         // WorkerT
 #include "utils/request_id_gen.h"   // utils::RequestIdGen
@@ -41,6 +48,11 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include "i_fsm.h"              // IFsm
 #include "i_callback.h"         // ICallback
 #include "process.h"            // Process
+#include "journal.h"            // Journal
+#include "deferred_callback.h"  // DeferredCallback
+#include "event_queue.h"        // EventQueue
+#include "native_process.h"     // NativeProcess
+#include "slot_map.h"           // SlotMap
 
 namespace fsm {
 
@@ -54,6 +66,19 @@ class FsmManager:
 {
     friend WorkerBase;
 
+public:
+
+    // creates the definition of a restored process without registered definition, is called in the locked state
+    typedef std::function<bool( uint32_t process_id, Process * process )> ProcessInitializer;
+
+    struct AdmissionStats
+    {
+        uint64_t    num_rejected;           // signals rejected by admission control
+        uint64_t    num_dropped;            // queued signals dropped to admit new ones
+        uint64_t    num_refused_processes;  // create_process() refused while overloaded
+        uint64_t    num_overloads;          // high watermark reached
+    };
+
 public:
     FsmManager();
     ~FsmManager();
@@ -66,6 +91,8 @@ public:
             std::string                         * error_msg );
 
     void consume( const ev::Object * req ) override;
+    // returns false if the event is rejected by admission control, it is deleted then
+    bool try_consume( const ev::Object * req, std::string * error_msg );
 
     void start();
 
@@ -73,16 +100,117 @@ public:
 
     uint32_t create_process();
 
+    // returns version of the definition, new processes are created with the latest version
+    uint32_t register_definition( const std::string & name, const Definition::Initializer & initializer );
+    // the same, running processes of previous versions are migrated, states, variables and timers are mapped by name
+    uint32_t register_definition( const std::string & name, const Definition::Initializer & initializer, const NameMapper & mapper );
+
+    uint32_t create_process( const std::string & definition_name );
+    // the parent is the target of SendSignal TO PARENT
+    uint32_t create_process( const std::string & definition_name, uint32_t parent_process_id );
+    // the same, the process is the target of ev::KeySignal with the key, returns 0 if the key is in use
+    uint32_t create_process( const std::string & definition_name, uint32_t parent_process_id, const std::string & correlation_key );
+
+    // e.g. for a process restored by load(), the keys are not included in snapshots and the journal,
+    // a key is removed when its process ends, returns false if there is no such process or the key is in use
+    bool set_correlation_key( uint32_t process_id, const std::string & correlation_key );
+    // returns 0 if the key is unknown
+    uint32_t find_process_id( const std::string & correlation_key ) const;
+
+    // signals of processes to processes are handled in the worker thread right after the current event,
+    // they bypass the priority lanes, admission control and coalescing
+    void send_signal( uint32_t process_id, const std::string & name, std::vector<Value> && arguments ) override;
+
+    // groups are targets of ev::Broadcast, a process may join several groups and leaves them when it ends,
+    // returns false if there is no such process
+    bool join_group( uint32_t process_id, const std::string & group_name );
+    void leave_group( uint32_t process_id, const std::string & group_name );
+
+    // processes of a native definition, e.g. generated by CppGenHelper, take precedence over an interpreted definition of the same name,
+    // they are not included in snapshots, the journal, the pool and the memory usage
+    void register_native_definition( const std::string & name, const NativeProcess::Factory & factory );
+
+    // approximate memory usage in bytes: of one process, of all processes of the definition (incl. pooled ones), total
+    std::size_t get_memory_usage( uint32_t process_id ) const;
+    std::size_t get_definition_memory_usage( const std::string & definition_name ) const;
+    std::size_t get_memory_usage() const;
+
+    // collects counters of signal handlers and action connectors per definition, see SdlGrHelper
+    void set_profiling_enabled( bool is_enabled );
+    // copies the profile of the latest version of the definition, returns false if the definition is unknown
+    bool get_profile( ExecutionProfile * profile, const std::string & definition_name ) const;
+    void clear_profile( const std::string & definition_name );
+
+    // runtime errors of a process don't throw, the process is terminated and reported via ICallback::handle_process_error(),
+    // exceptions of the callback or of value operations are caught per event, other processes are not affected
+    void set_exception_free( bool is_exception_free );
+    // number of processes terminated by an error in the exception-free mode
+    uint32_t get_num_failed_processes() const;
+
+    // number of signals merged into a queued signal, see Process::add_coalesced_signal()
+    uint64_t get_num_coalesced_signals() const;
+
+    // max number of ended processes kept per definition for reuse, 0 - ended processes are deleted
+    void set_max_pool_size( unsigned max_pool_size );
+
     void start_process( uint32_t process_id );
 
-    // must be called in the locked state
+    // must be called in the locked state, returns nullptr if the process has ended, i.e. a process id can be kept as a handle
     Process* find_process( uint32_t process_id );
 
     std::mutex      & get_mutex() const;
 
+    // if the journal is used, it is rotated, so that it holds the records after the snapshot only,
+    // the ones before are kept in <file_name>.prev until the next snapshot
+    void save( std::ostream & os ) const;
+    // must be called before any process was created
+    bool load( std::istream & is, const ProcessInitializer & initializer, std::string * error_msg );
+
+    // optional, must be called before start(), signals sent by processes are passed to ICallback
+    // once the journal record of their transition is synced (write-ahead)
+    bool init_journal( const std::string & file_name, unsigned max_batch_size, double max_delay, std::string * error_msg );
+    // replays the journal over the processes restored by load()
+    bool replay_journal( const std::string & file_name, const ProcessInitializer & initializer, std::string * error_msg );
+
+    // optional, must be called before start(), events are queued per lane, lane 0 is served first,
+    // control - StartProcess and journal flushes, max_bursts - see EventQueue
+    bool init_priority_lanes( unsigned lane_control, unsigned lane_timer, unsigned lane_signal, const std::vector<unsigned> & max_bursts, std::string * error_msg );
+    // empty if the priority lanes are not used
+    void get_lane_stats( std::vector<EventQueue::LaneStats> * stats ) const;
+
+    // optional, must be called before start() and after init_priority_lanes() if the lanes are used,
+    // limits the number of queued signals, timers and control events are always admitted,
+    // ICallback::handle_overload() is called at the watermarks, always alternately, it must not call consume(),
+    // while overloaded create_process() returns 0 if refuse_create_process is set
+    bool init_admission_control(
+            unsigned                            max_depth,
+            unsigned                            high_watermark,
+            unsigned                            low_watermark,
+            EventQueue::overload_policy_e       policy,
+            bool                                refuse_create_process,
+            std::string                         * error_msg );
+    void get_admission_stats( AdmissionStats * stats ) const;
+
 private:
 
-    typedef std::map<uint32_t,Process*>    MapIdToProcess;
+    typedef SlotMap<Process*>              MapIdToProcess;
+    typedef std::map<std::string,DefinitionPtr>     MapNameToDefinition;
+    typedef std::map<std::string,std::vector<Process*>> MapNameToPool;
+    typedef SlotMap<NativeProcess*>                     MapIdToNativeProcess;
+    typedef std::map<std::string,NativeProcess::Factory> MapNameToNativeFactory;
+    typedef std::map<uint32_t,const std::set<std::string>*>         MapIdToCoalescedSignals;
+    typedef std::map<std::pair<uint32_t,std::string>,const ev::Signal*> MapKeyToLatestSignal;
+    typedef std::map<std::string,std::set<uint32_t>>    MapNameToGroup;
+    typedef std::map<uint32_t,std::set<std::string>>    MapIdToGroupNames;
+    typedef std::unordered_map<std::string,uint32_t>    MapKeyToProcessId;
+    typedef std::unordered_map<uint32_t,std::string>    MapIdToKey;
+
+    enum class journal_event_type_e : uint8_t
+    {
+        SIGNAL          = 1,
+        TIMER,
+        START_PROCESS
+    };
 
 private:
     FsmManager( const FsmManager & )              = delete;
@@ -90,13 +218,74 @@ private:
 
     void handle( const ev::Object * req );
     void handle_Signal( const ev::Object & req );
+    // returns true if the process keeps the signal saved, must be called in the locked state
+    bool deliver_signal( const ev::Signal & req );
+    // the same, a shared signal is copied if it is saved
+    bool deliver_signal( MapIdToProcess::iterator it, const ev::Signal & req, bool is_shared );
+    void deliver_shared_signal( uint32_t process_id, const ev::Signal & req );
+    void handle_local_signals();
+    void handle_Broadcast( const ev::Object & req );
+    void handle_KeySignal( const ev::Object & req );
     void handle_StartProcess( const ev::Object & req );
     void handle_Timer( const ev::Object & req );
+    void handle_FlushJournal( const ev::Object & req );
     void release( const ev::Object * req ) const;
 
+    unsigned get_lane( const ev::Object & req ) const;
+
+    // returns true if the signal is merged into a queued one, it is owned by the manager then
+    bool coalesce( const ev::Object & req );
+    // the signal was not queued or was dropped, signals merged into it are discarded
+    void cancel_coalescing( const ev::Object & req );
+    // returns the latest signal merged into the dequeued one or the signal itself
+    const ev::Signal & take_latest_signal( const ev::Signal & req, std::unique_ptr<const ev::Signal> * latest );
+    void update_coalescing( uint32_t process_id, const Process * process );
+    void notify_watermark( EventQueue::watermark_e watermark );
+    // the event was dropped by admission control
+    void log_dropped( const ev::Object & req ) const;
+    // must be called in the locked state
+    bool is_create_process_refused();
+
     element_id_t get_next_id();
 
+    uint32_t create_process_intern( const std::string & definition_name, uint32_t parent_process_id );
+
     void check_process_end( MapIdToProcess::iterator it );
+    void check_process_end( MapIdToNativeProcess::iterator it );
+
+    // slot generations are persisted, so that ids issued before a restart are not reissued after a restore
+    template<class MAP>
+    static void save_generations( std::ostream & os, const MAP & map );
+    template<class MAP>
+    static bool load_generations( MAP * map, std::istream & is );
+    void leave_groups( uint32_t process_id );
+    void remove_correlation_key( uint32_t process_id );
+    // must be called in the locked state
+    bool set_correlation_key_intern( uint32_t process_id, const std::string & correlation_key );
+
+    // returns false if there is no such native process
+    bool handle_native_process( uint32_t process_id, const std::function<void( NativeProcess * process )> & handler );
+
+    void release_process( Process * process );
+    // exception-free mode and profile
+    void apply_options( Process * process );
+
+    // in the exception-free mode an exception of the handler terminates the process
+    void execute_process( Process * process, const std::function<void( Process * process )> & handler );
+    void report_process_error( uint32_t process_id, const std::string & error );
+    void clear_pool( const std::string & definition_name );
+
+    DefinitionPtr register_definition_intern( const std::string & name, const Definition::Initializer & initializer );
+    void migrate_processes( const DefinitionPtr & definition, const NameMapper & mapper );
+    bool init_restored_process( Process * process, uint32_t process_id, const std::string & definition_name, uint32_t definition_version, const ProcessInitializer & initializer );
+
+    void begin_journal_record( journal_event_type_e type, uint32_t process_id );
+    void end_journal_record( Process * process );
+    void schedule_journal_flush();
+    void cancel_journal_flush();
+    // is called unlocked, passes the signals of the synced records to the callback
+    void flush_journal();
+    static bool read_journal_event( std::string * definition_name, uint32_t * definition_version, journal_event_type_e type, std::istream & is );
 
 private:
 
@@ -107,9 +296,68 @@ private:
     ICallback                   * callback_;
     scheduler::IScheduler       * scheduler_;
 
+    // callback of the interpreted processes, holds their signals while the journal is used
+    DeferredCallback            deferred_callback_;
+
 
     MapIdToProcess                  map_id_to_process_;
 
+    MapNameToDefinition         map_name_to_definition_;
+
+    bool                        is_profiling_enabled_;
+
+    bool                        is_exception_free_;
+    uint32_t                    num_failed_processes_;
+
+    unsigned                    max_pool_size_;
+    MapNameToPool               map_name_to_pool_;
+
+    MapIdToNativeProcess        map_id_to_native_process_;
+    MapNameToNativeFactory      map_name_to_native_factory_;
+
+    std::unique_ptr<Journal>    journal_;
+    scheduler::Duration         journal_max_delay_;
+    std::ostringstream          journal_record_;
+    scheduler::job_id_t         journal_flush_job_id_;
+    // the batch is flushed after the current event, e.g. the delayed flush cannot be scheduled
+    bool                        is_journal_flush_due_;
+
+    std::unique_ptr<EventQueue> event_queue_;
+    unsigned                    lane_control_;
+    unsigned                    lane_timer_;
+    unsigned                    lane_signal_;
+    // is passed to WorkerBase once per queued event, handle() takes the next event of the highest lane instead
+    ev::Object                  dequeue_token_;
+
+    bool                        is_create_process_refused_on_overload_;
+    uint64_t                    num_refused_processes_;
+
+    // serializes the watermark notifications of the producers and the worker
+    std::mutex                  watermark_mutex_;
+    bool                        is_overload_reported_;
+
+    // is locked after mutex_, consume() locks it alone
+    mutable std::mutex          coalescing_mutex_;
+    MapIdToCoalescedSignals     map_id_to_coalesced_signals_;
+    // per queued coalesced signal, the latest signal merged into it or nullptr
+    MapKeyToLatestSignal        map_key_to_latest_signal_;
+    uint64_t                    num_coalesced_signals_;
+    // merged signals discarded with a dropped queued signal, are counted as dropped
+    uint64_t                    num_dropped_merged_signals_;
+
+    // the handled event is kept by a process, e.g. a saved signal
+    bool                        is_req_taken_;
+
+    // signals sent by processes, see send_signal()
+    std::deque<const ev::Signal*>   local_signals_;
+
+    MapNameToGroup              map_name_to_group_;
+    MapIdToGroupNames           map_id_to_group_names_;
+
+    // is used by the worker in the locked state, so it needs no lock of its own
+    MapKeyToProcessId           map_key_to_process_id_;
+    MapIdToKey                  map_id_to_key_;
+
     utils::RequestIdGen         req_id_gen_;
 };
 
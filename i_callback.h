@@ -19,12 +19,13 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-// $Revision: 11611 $ $Date:: 2019-05-24 #$ $Author: serge $
+// $Revision: 11653 $ $Date:: 2019-06-13 #$ $Author: serge $
 
 #ifndef LIB_FSM__I_CALLBACK_H
 #define LIB_FSM__I_CALLBACK_H
 
 #include <vector>               // std::vector
+#include <string>               // std::string
 
 #include "elements.h"              // Value
 
@@ -36,6 +37,16 @@ struct ICallback
 
     virtual void handle_send_signal( uint32_t process_id, const std::string & name, const std::vector<Value> & arguments )       = 0;
     virtual void handle_function_call( uint32_t process_id, const std::string & name, const std::vector<Value*> & arguments )    = 0;
+
+    // optional, the process was terminated by a runtime error in the exception-free mode of FsmManager
+    virtual void handle_process_error( uint32_t /* process_id */, const std::string & /* error */ )
+    {
+    }
+
+    // optional, the event queue of FsmManager reached the high watermark (is_overloaded) or fell to the low one
+    virtual void handle_overload( bool /* is_overloaded */, uint32_t /* queue_depth */ )
+    {
+    }
 };
 
 } // namespace fsm
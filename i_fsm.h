@@ -19,12 +19,16 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-// $Revision: 10288 $ $Date:: 2018-12-20 #$ $Author: serge $
+// $Revision: 11664 $ $Date:: 2019-06-19 #$ $Author: serge $
 
 #ifndef LIB_FSM__I_FSM_H
 #define LIB_FSM__I_FSM_H
 
+#include <string>               // std::string
+#include <vector>               // std::vector
+
 #include "object.h"             // Object
+#include "signal.h"             // Signal
 
 namespace fsm {
 
@@ -34,6 +38,12 @@ public:
     virtual ~IFsm() {};
 
     virtual void consume( const ev::Object * req ) = 0;
+
+    // signal of a process to another one, is called while the sender is executed
+    virtual void send_signal( uint32_t process_id, const std::string & name, std::vector<Value> && arguments )
+    {
+        consume( new ev::Signal( process_id, name, std::move( arguments ) ) );
+    }
 };
 
 } // namespace fsm
@@ -0,0 +1,323 @@
+/*
+
+FSM. Write-ahead journal.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11624 $ $Date:: 2019-05-29 #$ $Author: serge $
+
+#include "journal.h"            // self
+
+#include <cassert>              // assert
+#include <cerrno>               // errno
+#include <cstdio>               // rename
+#include <cstring>              // strerror
+#include <fcntl.h>              // open
+#include <unistd.h>             // write, pread, fdatasync, close
+
+#include "utils/dummy_logger.h"     // dummy_log_debug
+#include "utils/mutex_helper.h"     // MUTEX_SCOPE_LOCK
+
+#include "serializer.h"         // Serializer
+
+namespace fsm {
+
+const uint32_t HEADER_MAGIC     = 0x484a5346;  // "FSJH"
+const uint32_t RECORD_MAGIC     = 0x4e4a5346;  // "FSJN"
+
+Journal::Journal( uint32_t log_id ):
+        log_id_( log_id ),
+        fd_( -1 ),
+        max_batch_size_( 1 ),
+        batch_size_( 0 ),
+        num_records_( 0 ),
+        num_durable_records_( 0 ),
+        num_flushes_( 0 ),
+        pending_size_( 0 ),
+        pending_last_record_( 0 ),
+        num_written_( 0 )
+{
+}
+
+Journal::~Journal()
+{
+    if( fd_ != -1 )
+    {
+        flush();
+
+        ::close( fd_ );
+    }
+
+    dummy_log_info( log_id_, "journal %s: %u records, %u flushes", file_name_.c_str(), unsigned( num_records_ ), unsigned( num_flushes_ ) );
+}
+
+bool Journal::init( const std::string & file_name, unsigned max_batch_size, std::string * error_msg )
+{
+    assert( fd_ == -1 );
+    assert( max_batch_size > 0 );
+
+    fd_ = open_file( file_name, error_msg );
+
+    if( fd_ == -1 )
+        return false;
+
+    file_name_      = file_name;
+    max_batch_size_ = max_batch_size;
+
+    dummy_log_info( log_id_, "journal %s: opened, max batch size %u", file_name_.c_str(), max_batch_size_ );
+
+    return true;
+}
+
+bool Journal::append( const std::string & record )
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    auto is_first = ( batch_size_ == 0 );
+
+    uint32_t header[2] = { RECORD_MAGIC, uint32_t( record.size() ) };
+
+    batch_.append( reinterpret_cast<const char*>( header ), sizeof( header ) );
+    batch_.append( record );
+
+    ++batch_size_;
+    ++num_records_;
+
+    return is_first;
+}
+
+bool Journal::is_flush_needed() const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    return batch_size_ >= max_batch_size_;
+}
+
+bool Journal::flush()
+{
+    MUTEX_SCOPE_LOCK( io_mutex_ );
+
+    return flush_intern();
+}
+
+bool Journal::rotate( std::string * error_msg )
+{
+    MUTEX_SCOPE_LOCK( io_mutex_ );
+
+    if( flush_intern() == false )
+    {
+        * error_msg = "cannot flush journal " + file_name_;
+        return false;
+    }
+
+    auto prev_file_name = file_name_ + ".prev";
+
+    if( ::rename( file_name_.c_str(), prev_file_name.c_str() ) != 0 )
+    {
+        * error_msg = "cannot rename journal " + file_name_ + ": " + strerror( errno );
+        return false;
+    }
+
+    // the renamed file is still open, so records are not lost if the new one cannot be opened
+    auto fd = open_file( file_name_, error_msg );
+
+    if( fd == -1 )
+        return false;
+
+    ::close( fd_ );
+
+    fd_ = fd;
+
+    dummy_log_info( log_id_, "journal %s: rotated, previous records are in %s", file_name_.c_str(), prev_file_name.c_str() );
+
+    return true;
+}
+
+uint64_t Journal::get_num_records() const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    return num_records_;
+}
+
+uint64_t Journal::get_num_durable_records() const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    return num_durable_records_;
+}
+
+int Journal::open_file( const std::string & file_name, std::string * error_msg )
+{
+    auto fd = ::open( file_name.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644 );
+
+    if( fd == -1 )
+    {
+        * error_msg = "cannot open journal " + file_name + ": " + strerror( errno );
+        return -1;
+    }
+
+    uint32_t header[2];
+
+    auto res = ::pread( fd, header, sizeof( header ), 0 );
+
+    if( res == sizeof( header ) )
+    {
+        if( header[0] != HEADER_MAGIC || header[1] != VERSION )
+        {
+            ::close( fd );
+            * error_msg = "journal " + file_name + ": not a journal or unsupported version " + std::to_string( header[1] );
+            return -1;
+        }
+
+        return fd;
+    }
+
+    if( res != 0 )
+    {
+        ::close( fd );
+        * error_msg = "journal " + file_name + ": cannot read header" + ( res < 0 ? std::string( ": " ) + strerror( errno ) : std::string() );
+        return -1;
+    }
+
+    // new file, the header is synced, so that the records are never written before it
+    header[0]   = HEADER_MAGIC;
+    header[1]   = VERSION;
+
+    if( ::write( fd, header, sizeof( header ) ) != sizeof( header ) || ::fdatasync( fd ) != 0 )
+    {
+        * error_msg = "journal " + file_name + ": cannot write header: " + strerror( errno );
+        ::close( fd );
+        return -1;
+    }
+
+    return fd;
+}
+
+bool Journal::flush_intern()
+{
+    {
+        MUTEX_SCOPE_LOCK( mutex_ );
+
+        // a batch kept by a failed flush is written first
+        if( pending_size_ == 0 )
+            pending_.swap( batch_ );
+        else
+            pending_.append( batch_ );
+
+        pending_size_       += batch_size_;
+        pending_last_record_ = num_records_;
+
+        // keeps the capacity, i.e. steady-state batching doesn't allocate
+        batch_.clear();
+        batch_size_         = 0;
+    }
+
+    if( pending_size_ == 0 )
+        return true;
+
+    // a failed flush is retried from the first byte not written, so that no record is written twice
+    auto p      = pending_.data() + num_written_;
+    auto size   = pending_.size() - num_written_;
+
+    while( size > 0 )
+    {
+        auto res = ::write( fd_, p, size );
+
+        if( res < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+
+            dummy_log_error( log_id_, "journal %s: cannot write: %s", file_name_.c_str(), strerror( errno ) );
+            return false;
+        }
+
+        p               += res;
+        size            -= res;
+        num_written_    += res;
+    }
+
+    if( ::fdatasync( fd_ ) != 0 )
+    {
+        dummy_log_error( log_id_, "journal %s: cannot sync: %s", file_name_.c_str(), strerror( errno ) );
+        return false;
+    }
+
+    dummy_log_debug( log_id_, "journal %s: flushed %u records, %u bytes", file_name_.c_str(), pending_size_, unsigned( pending_.size() ) );
+
+    pending_.clear();
+    pending_size_   = 0;
+    num_written_    = 0;
+
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    num_durable_records_    = pending_last_record_;
+
+    ++num_flushes_;
+
+    return true;
+}
+
+bool Journal::read_header( std::istream & is, std::string * error_msg )
+{
+    uint32_t magic;
+    uint32_t version;
+
+    if( Serializer::load( & magic, is ) == false || Serializer::load( & version, is ) == false )
+    {
+        * error_msg = "cannot read journal header";
+        return false;
+    }
+
+    if( magic != HEADER_MAGIC )
+    {
+        * error_msg = "not a journal";
+        return false;
+    }
+
+    if( version != VERSION )
+    {
+        * error_msg = "unsupported journal version " + std::to_string( version );
+        return false;
+    }
+
+    return true;
+}
+
+bool Journal::read_record( std::string * record, std::istream & is )
+{
+    uint32_t magic;
+    uint32_t size;
+
+    if( Serializer::load( & magic, is ) == false || Serializer::load( & size, is ) == false )
+        return false;
+
+    if( magic != RECORD_MAGIC )
+        return false;
+
+    record->resize( size );
+
+    if( size == 0 )
+        return true;
+
+    // a torn record at the end of the journal is treated as its end
+    return static_cast<bool>( is.read( & ( * record )[0], size ) );
+}
+
+} // namespace fsm
@@ -0,0 +1,105 @@
+/*
+
+FSM. Write-ahead journal.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11624 $ $Date:: 2019-05-29 #$ $Author: serge $
+
+#ifndef LIB_FSM__JOURNAL_H
+#define LIB_FSM__JOURNAL_H
+
+#include <cstdint>              // uint32_t
+#include <string>               // std::string
+#include <istream>              // std::istream
+#include <mutex>                // std::mutex
+
+namespace fsm {
+
+// append-only file of length-prefixed records after a header with the format version,
+// records are collected into a batch and written with one fdatasync (group commit),
+// the batch is taken over by flush(), so that records can be appended while the previous batch is synced
+class Journal
+{
+public:
+    // format of the header and the records incl. the process deltas, a journal of another version is rejected
+    static const uint32_t VERSION = 1;
+
+    Journal( uint32_t log_id );
+    ~Journal();
+
+    // writes the header into a new or empty file, checks it in an existing one
+    bool init( const std::string & file_name, unsigned max_batch_size, std::string * error_msg );
+
+    // returns true if the batch was empty before, i.e. a delayed flush has to be scheduled
+    bool append( const std::string & record );
+
+    bool is_flush_needed() const;
+
+    bool flush();
+
+    // flushes and renames the file to <file_name>.prev, replacing the previous one, new records go to a new file
+    bool rotate( std::string * error_msg );
+
+    // records appended, i.e. the number of the last one
+    uint64_t get_num_records() const;
+    // records written and synced
+    uint64_t get_num_durable_records() const;
+
+    // is read before the records
+    static bool read_header( std::istream & is, std::string * error_msg );
+    static bool read_record( std::string * record, std::istream & is );
+
+private:
+    Journal( const Journal & )              = delete;
+    Journal & operator=( const Journal & )  = delete;
+
+    static int open_file( const std::string & file_name, std::string * error_msg );
+
+    bool flush_intern();
+
+private:
+
+    uint32_t                    log_id_;
+
+    // serializes writes, syncs and rotation, is locked before mutex_
+    std::mutex                  io_mutex_;
+
+    int                         fd_;
+    std::string                 file_name_;
+    unsigned                    max_batch_size_;
+
+    mutable std::mutex          mutex_;
+
+    std::string                 batch_;
+    unsigned                    batch_size_;
+    uint64_t                    num_records_;
+    uint64_t                    num_durable_records_;
+    uint64_t                    num_flushes_;
+
+    // taken over by flush(), kept after a failed one, is accessed under io_mutex_
+    std::string                 pending_;
+    unsigned                    pending_size_;
+    uint64_t                    pending_last_record_;
+    // bytes of the pending batch written by a failed flush
+    std::size_t                 num_written_;
+};
+
+} // namespace fsm
+
+#endif // LIB_FSM__JOURNAL_H
@@ -34,6 +34,9 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include "elements.h"               // compare_values
 #include "syntax_error.h"           // SyntaxError
 #include "str_helper.h"             // StrHelper
+#include "serializer.h"             // Serializer
+#include "size_helper.h"            // SizeHelper
+#include "typed_operations.h"       // TypedOperations
 
 namespace fsm {
 
@@ -45,7 +48,9 @@ Memory::Memory(
         id_( id ),
         log_id_( log_id ),
         req_id_gen_( req_id_gen ),
-        names_( names )
+        names_( names ),
+        string_pool_( nullptr ),
+        is_exception_free_( false )
 {
 //    dummy_logi_info( log_id_, id_, "created" );
 }
@@ -71,9 +76,9 @@ element_id_t Memory::create_add_variable_core( const std::string & name, data_ty
 {
     auto id = get_next_id();
 
-    auto obj = is_inited ? new Variable( log_id_, id, name, type, value ) : new Variable( log_id_, id, name, type );
+    std::unique_ptr<Variable> obj( is_inited ? new Variable( log_id_, id, name, type, make_compact_value( type, value ) ) : new Variable( log_id_, id, name, type ) );
 
-    auto b = map_id_to_variable_.insert( std::make_pair( id, obj ) ).second;
+    auto b = map_id_to_variable_.insert( std::make_pair( id, std::move( obj ) ) ).second;
 
     assert( b );
 
@@ -88,9 +93,9 @@ element_id_t Memory::create_add_constant( const std::string & name, data_type_e
 {
     auto id = get_next_id();
 
-    auto obj = new Constant( log_id_, id, name, type, value );
+    std::unique_ptr<Constant> obj( new Constant( log_id_, id, name, type, make_compact_value( type, value ) ) );
 
-    auto b = map_id_to_constant_.insert( std::make_pair( id, obj ) ).second;
+    auto b = map_id_to_constant_.insert( std::make_pair( id, std::move( obj ) ) ).second;
 
     assert( b );
 
@@ -101,9 +106,66 @@ element_id_t Memory::create_add_constant( const std::string & name, data_type_e
     return id;
 }
 
+CompactValue Memory::make_compact_value( data_type_e type, const Value & value ) const
+{
+    Value v;
+
+    v.type = type;
+
+    assign( & v, value );
+
+    if( string_pool_ )
+        return string_pool_->intern( v );
+
+    return CompactValue( v );
+}
+
+void Memory::set_string_pool( StringPool * string_pool )
+{
+    string_pool_    = string_pool;
+}
+
+void Memory::reset( uint32_t id )
+{
+    id_ = id;
+
+    error_.clear();
+
+    clear_temp_variables();
+
+    for( auto & e : map_id_to_variable_ )
+    {
+        e.second->reset();
+    }
+}
+
+void Memory::set_exception_free( bool is_exception_free )
+{
+    is_exception_free_  = is_exception_free;
+}
+
+bool Memory::has_error() const
+{
+    return error_.empty() == false;
+}
+
+const std::string & Memory::get_error() const
+{
+    return error_;
+}
+
+void Memory::raise_error( const std::string & error )
+{
+    if( is_exception_free_ == false )
+        throw SyntaxError( error );
+
+    if( error_.empty() )
+        error_  = error;
+}
+
 void Memory::clear_temp_variables()
 {
-    for( auto e : map_id_to_temp_variable_ )
+    for( auto & e : map_id_to_temp_variable_ )
     {
         auto id = e.first;
         auto b = names_->delete_name( id );
@@ -140,9 +202,9 @@ element_id_t Memory::create_temp_variable( const Value & v, unsigned n )
 
     auto name = "$" + std::to_string( n );
 
-    auto obj = new Variable( log_id_, id, name, v.type, v );
+    std::unique_ptr<Variable> obj( new Variable( log_id_, id, name, v.type, v ) );
 
-    auto b = map_id_to_temp_variable_.insert( std::make_pair( id, obj ) ).second;
+    auto b = map_id_to_temp_variable_.insert( std::make_pair( id, std::move( obj ) ) ).second;
 
     assert( b );
 
@@ -160,7 +222,7 @@ Variable* Memory::find_variable( element_id_t id )
 
         if( it != map_id_to_variable_.end() )
         {
-            return it->second;
+            return it->second.get();
         }
     }
 
@@ -169,7 +231,7 @@ Variable* Memory::find_variable( element_id_t id )
 
         if( it != map_id_to_temp_variable_.end() )
         {
-            return it->second;
+            return it->second.get();
         }
     }
 
@@ -183,7 +245,7 @@ const Variable* Memory::find_variable( element_id_t id ) const
 
         if( it != map_id_to_variable_.end() )
         {
-            return it->second;
+            return it->second.get();
         }
     }
 
@@ -192,7 +254,7 @@ const Variable* Memory::find_variable( element_id_t id ) const
 
         if( it != map_id_to_temp_variable_.end() )
         {
-            return it->second;
+            return it->second.get();
         }
     }
 
@@ -212,7 +274,7 @@ const Constant* Memory::find_constant( element_id_t id ) const
 
     if( it != map_id_to_constant_.end() )
     {
-        return it->second;
+        return it->second.get();
     }
 
     return nullptr;
@@ -228,7 +290,7 @@ void Memory::evaluate_expressions( std::vector<Value> * values, const std::vecto
 
         evaluate_expression( & v, e );
 
-        values->push_back( v );
+        values->push_back( std::move( v ) );
     }
 }
 
@@ -242,7 +304,7 @@ void Memory::evaluate_expressions( std::vector<Value> * values, const std::vecto
 
         evaluate_expression( & v, e.second );
 
-        values->push_back( v );
+        values->push_back( std::move( v ) );
     }
 }
 
@@ -253,7 +315,7 @@ void Memory::convert_variable_to_value( Value * value, element_id_t variable_id
 
         if( it != map_id_to_variable_.end() )
         {
-            assign( value, it->second->get() );
+            it->second->get( value );
             return;
         }
     }
@@ -263,7 +325,7 @@ void Memory::convert_variable_to_value( Value * value, element_id_t variable_id
 
         if( it != map_id_to_temp_variable_.end() )
         {
-            assign( value, it->second->get() );
+            it->second->get( value );
             return;
         }
     }
@@ -273,14 +335,13 @@ void Memory::convert_variable_to_value( Value * value, element_id_t variable_id
 
         if( it != map_id_to_constant_.end() )
         {
-            assign( value, it->second->get() );
+            it->second->get( value );
             return;
         }
     }
 
     dummy_log_fatal( log_id_, id_, "convert_variable_to_value: variable_id %u not found in the list of variables, temp variables, and constants", variable_id );
-    assert( 0 );
-    throw SyntaxError( "convert_variable_to_value: variable_id " + std::to_string( variable_id ) + " not found in the list of variables, temp variables, and constants" );
+    raise_error( "convert_variable_to_value: variable_id " + std::to_string( variable_id ) + " not found in the list of variables, temp variables, and constants" );
 }
 
 void Memory::import_values_into_variables( const std::vector<std::pair<bool,ExpressionPtr>> & arguments, const std::vector<Value> & values )
@@ -322,8 +383,8 @@ void Memory::import_values_into_variables( const std::vector<std::pair<bool,Expr
         else
         {
             dummy_logi_fatal( log_id_, id_, "argument is not a variable %s", typeid( eexpr ).name() );
-            assert( 0 );
-            throw SyntaxError( "argument is not a variable " + std::string( typeid( eexpr ).name() ) );
+            raise_error( "argument is not a variable " + std::string( typeid( eexpr ).name() ) );
+            return;
         }
 
         ++i;
@@ -347,20 +408,202 @@ void Memory::import_value_into_variable( element_id_t variable_id, const Value &
     if( variable == nullptr )
     {
         dummy_log_fatal( log_id_, id_, "import_value_into_variable: variable_id %u not found in the list of variables and temp variables", variable_id );
-        assert( 0 );
-        throw SyntaxError( "import_values_into_variables: variable_id " + std::to_string( variable_id ) + " not found in the list of variables and temp variables" );
+        raise_error( "import_values_into_variables: variable_id " + std::to_string( variable_id ) + " not found in the list of variables and temp variables" );
+        return;
     }
 
     dummy_logi_debug( log_id_, id_, "import_value_into_variable: %s (%i) = %s", variable->get_name().c_str(), variable->get_id(), anyvalue::StrHelper::to_string( value ).c_str() );
 
+    // typed operations rely on the declared type of a variable, temporary variables are not typed statically
+    if( value.type != variable->get_type() && map_id_to_variable_.count( variable_id ) )
+    {
+        if( is_numeric( value.type ) == false || is_numeric( variable->get_type() ) == false )
+        {
+            dummy_logi_fatal( log_id_, id_, "import_value_into_variable: %s of type %s cannot hold %s", variable->get_name().c_str(),
+                    anyvalue::StrHelper::to_string( variable->get_type() ).c_str(), anyvalue::StrHelper::to_string( value ).c_str() );
+            raise_error( "import_values_into_variables: type mismatch: " + variable->get_name() + " of type " + anyvalue::StrHelper::to_string( variable->get_type() ) );
+            return;
+        }
+
+        variable->assign( value );
+
+        return;
+    }
+
     variable->set( value );
 }
 
+bool Memory::is_constant_expression( const Expression & expr ) const
+{
+    if( typeid( expr ) == typeid( ExpressionValue ) )
+    {
+        return true;
+    }
+    else if( typeid( expr ) == typeid( ExpressionVariable ) )
+    {
+        auto & a = dynamic_cast< const ExpressionVariable &>( expr );
+
+        return find_constant( a.variable_id ) != nullptr;
+    }
+    else if( typeid( expr ) == typeid( ExpressionVariableName ) )
+    {
+        auto & a = dynamic_cast< const ExpressionVariableName &>( expr );
+
+        return find_constant( names_->find_element( a.variable_name ) ) != nullptr;
+    }
+    else if( typeid( expr ) == typeid( UnaryExpression ) )
+    {
+        auto & a = dynamic_cast< const UnaryExpression &>( expr );
+
+        return is_constant_expression( * a.op );
+    }
+    else if( typeid( expr ) == typeid( BinaryExpression ) )
+    {
+        auto & a = dynamic_cast< const BinaryExpression &>( expr );
+
+        return is_constant_expression( * a.lhs ) && is_constant_expression( * a.rhs );
+    }
+
+    return false;
+}
+
+data_type_e Memory::check_types( Expression & expr )
+{
+    if( typeid( expr ) == typeid( ExpressionValue ) )
+    {
+        auto & a = dynamic_cast< ExpressionValue &>( expr );
+
+        // each expression is checked once at finalize, so the literals are interned here
+        if( string_pool_ )
+            a.value = string_pool_->intern( a.value );
+
+        return a.value.get_type();
+    }
+    else if( typeid( expr ) == typeid( ExpressionVariable ) )
+    {
+        return get_element_type( dynamic_cast< const ExpressionVariable &>( expr ).variable_id );
+    }
+    else if( typeid( expr ) == typeid( ExpressionVariableName ) )
+    {
+        // temporary variables, i.e. signal arguments, are unknown here
+        return get_element_type( names_->find_element( dynamic_cast< const ExpressionVariableName &>( expr ).variable_name ) );
+    }
+    else if( typeid( expr ) == typeid( UnaryExpression ) )
+    {
+        auto & a = dynamic_cast< UnaryExpression &>( expr );
+
+        auto op_type = check_types( * a.op );
+
+        if( op_type == data_type_e::UNDEF )
+            return data_type_e::UNDEF;
+
+        auto is_valid =
+                ( a.type == unary_operation_type_e::NOT && op_type == data_type_e::BOOL ) ||
+                ( a.type == unary_operation_type_e::NEG && is_numeric( op_type ) );
+
+        if( is_valid == false )
+        {
+            dummy_logi_fatal( log_id_, id_, "type mismatch: unary operation %s on %s",
+                    anyvalue::StrHelper::to_string_short( a.type ).c_str(), anyvalue::StrHelper::to_string( op_type ).c_str() );
+            throw SyntaxError( "type mismatch: unary operation " + anyvalue::StrHelper::to_string_short( a.type ) + " on " + anyvalue::StrHelper::to_string( op_type ) );
+        }
+
+        a.operand_type  = op_type;
+        a.operation     = TypedOperations::find_unary_operation( a.type, op_type );
+
+        return op_type;
+    }
+    else if( typeid( expr ) == typeid( BinaryExpression ) )
+    {
+        auto & a = dynamic_cast< BinaryExpression &>( expr );
+
+        auto lhs_type = check_types( * a.lhs );
+        auto rhs_type = check_types( * a.rhs );
+
+        if( lhs_type == data_type_e::UNDEF || rhs_type == data_type_e::UNDEF )
+            return data_type_e::UNDEF;
+
+        auto is_logical = ( a.type == binary_operation_type_e::AND || a.type == binary_operation_type_e::OR );
+
+        if( is_logical && lhs_type == data_type_e::BOOL && rhs_type == data_type_e::BOOL )
+        {
+            a.operand_type  = data_type_e::BOOL;
+            a.operation     = TypedOperations::find_binary_operation( a.type, data_type_e::BOOL );
+            return data_type_e::BOOL;
+        }
+
+        if( is_logical == false && is_numeric( lhs_type ) && is_numeric( rhs_type ) )
+        {
+            if( lhs_type != rhs_type )
+                return data_type_e::UNDEF;  // int and double are harmonized by anyvalue at runtime
+
+            a.operand_type  = lhs_type;
+            a.operation     = TypedOperations::find_binary_operation( a.type, lhs_type );
+            return lhs_type;
+        }
+
+        if( a.type == binary_operation_type_e::PLUS && lhs_type == data_type_e::STRING && rhs_type == data_type_e::STRING )
+        {
+            return data_type_e::STRING;
+        }
+
+        dummy_logi_fatal( log_id_, id_, "type mismatch: %s %s %s",
+                anyvalue::StrHelper::to_string( lhs_type ).c_str(), anyvalue::StrHelper::to_string_short( a.type ).c_str(), anyvalue::StrHelper::to_string( rhs_type ).c_str() );
+        throw SyntaxError( "type mismatch: " + anyvalue::StrHelper::to_string( lhs_type ) + " " + anyvalue::StrHelper::to_string_short( a.type ) + " " + anyvalue::StrHelper::to_string( rhs_type ) );
+    }
+
+    return data_type_e::UNDEF;
+}
+
+data_type_e Memory::get_element_type( element_id_t id ) const
+{
+    auto variable = find_variable( id );
+
+    if( variable != nullptr )
+        return variable->get_type();
+
+    auto constant = find_constant( id );
+
+    if( constant != nullptr )
+        return constant->get_type();
+
+    return data_type_e::UNDEF;
+}
+
+bool Memory::is_numeric( data_type_e type )
+{
+    return type == data_type_e::INT || type == data_type_e::DOUBLE;
+}
+
 void Memory::evaluate_expression( Value * value, ExpressionPtr expr )
 {
     evaluate_expression( value, * expr.get() );
 }
 
+const CompactValue * Memory::find_compact_value( const Expression & expr ) const
+{
+    if( typeid( expr ) == typeid( ExpressionValue ) )
+    {
+        return & dynamic_cast< const ExpressionValue &>( expr ).value;
+    }
+    else if( typeid( expr ) == typeid( ExpressionVariable ) )
+    {
+        auto id = dynamic_cast< const ExpressionVariable &>( expr ).variable_id;
+
+        auto variable = find_variable( id );
+
+        if( variable )
+            return & variable->get_compact_value();
+
+        auto constant = find_constant( id );
+
+        if( constant )
+            return & constant->get_compact_value();
+    }
+
+    return nullptr;
+}
+
 void Memory::evaluate_expression( Value * value, const Expression & expr )
 {
     typedef Memory Type;
@@ -385,8 +628,8 @@ void Memory::evaluate_expression( Value * value, const Expression & expr )
     if( it == funcs.end() )
     {
         dummy_logi_fatal( log_id_, id_, "unsupported expression type %s", typeid( expr ).name() );
-        assert( 0 );
-        throw SyntaxError( "unsupported expression type " + std::string( typeid( expr ).name() ) );
+        raise_error( "unsupported expression type " + std::string( typeid( expr ).name() ) );
+        return;
     }
 
     (this->*it->second)( value, expr );
@@ -396,7 +639,7 @@ void Memory::evaluate_expression_ExpressionValue( Value * value, const Expressio
 {
     auto & a = dynamic_cast< const ExpressionValue&>( eexpr );
 
-    assign( value, a.value );
+    a.value.get( value );
 }
 
 void Memory::evaluate_expression_ExpressionVariable( Value * value, const Expression & eexpr )
@@ -412,7 +655,13 @@ void Memory::evaluate_expression_ExpressionVariableName( Value * value, const Ex
 
     auto variable_id = names_->find_element( a.variable_name );
 
-    assert( variable_id );
+    // e.g. a signal argument the signal doesn't have
+    if( variable_id == 0 )
+    {
+        dummy_logi_fatal( log_id_, id_, "variable %s not found", a.variable_name.c_str() );
+        raise_error( "variable " + a.variable_name + " not found" );
+        return;
+    }
 
     convert_variable_to_value( value, variable_id );
 }
@@ -425,6 +674,16 @@ void Memory::evaluate_expression_UnaryExpression( Value * value, const Expressio
 
     evaluate_expression( & temp, a.op );
 
+    // the operand is undefined
+    if( has_error() )
+        return;
+
+    if( a.operation )
+    {
+        a.operation( value, temp );
+        return;
+    }
+
     anyvalue::unary_operation( value, a.type, temp );
 }
 
@@ -438,12 +697,138 @@ void Memory::evaluate_expression_BinaryExpression( Value * value, const Expressi
     evaluate_expression( & lhs, a.lhs );
     evaluate_expression( & rhs, a.rhs );
 
+    // an operand is undefined
+    if( has_error() )
+        return;
+
+    if( a.operation )
+    {
+        a.operation( value, lhs, rhs );
+        return;
+    }
+
     anyvalue::binary_operation( value, a.type, lhs, rhs );
 }
 
+void Memory::save( std::ostream & os ) const
+{
+    Serializer::save( os, uint32_t( map_id_to_variable_.size() ) );
+
+    for( auto & e : map_id_to_variable_ )
+    {
+        Value value;
+
+        e.second->get( & value );
+
+        Serializer::save( os, e.second->get_name() );
+        Serializer::save( os, value );
+    }
+}
+
+void Memory::save_changed( std::ostream & os )
+{
+    uint32_t size = 0;
+
+    for( auto & e : map_id_to_variable_ )
+    {
+        if( e.second->is_changed() )
+            ++size;
+    }
+
+    Serializer::save( os, size );
+
+    for( auto & e : map_id_to_variable_ )
+    {
+        auto & v = * e.second;
+
+        if( v.is_changed() == false )
+            continue;
+
+        Value value;
+
+        v.get( & value );
+
+        Serializer::save( os, v.get_name() );
+        Serializer::save( os, value );
+
+        v.clear_changed();
+    }
+}
+
+bool Memory::load( std::istream & is, const NameMapper & mapper, std::string * error_msg )
+{
+    uint32_t size;
+
+    if( Serializer::load( & size, is ) == false )
+    {
+        * error_msg = "cannot read number of variables";
+        return false;
+    }
+
+    for( uint32_t i = 0; i < size; ++i )
+    {
+        std::string name;
+        Value       value;
+
+        if( Serializer::load( & name, is ) == false || Serializer::load( & value, is ) == false )
+        {
+            * error_msg = "cannot read variable";
+            return false;
+        }
+
+        if( mapper )
+            name = mapper( name );
+
+        auto variable = name.empty() ? nullptr : find_variable( name );
+
+        if( variable == nullptr )
+        {
+            // variable was removed from the definition, ignore it
+            dummy_logi_warn( log_id_, id_, "load: unknown variable %s, ignored", name.c_str() );
+            continue;
+        }
+
+        // the value is stored as is, i.e. it must have the declared type, e.g. a variable of another definition may have another one
+        if( value.type != variable->get_type() )
+        {
+            * error_msg = "variable " + name + ": stored type " + anyvalue::StrHelper::to_string( value.type )
+                    + " doesn't match declared type " + anyvalue::StrHelper::to_string( variable->get_type() );
+            return false;
+        }
+
+        variable->set( value );
+    }
+
+    dummy_logi_debug( log_id_, id_, "load: loaded %u variables", size );
+
+    return true;
+}
+
 element_id_t Memory::get_next_id()
 {
     return req_id_gen_->get_next_request_id();
 }
 
+std::size_t Memory::get_memory_usage() const
+{
+    std::size_t res = 0;
+
+    for( auto & e : map_id_to_variable_ )
+    {
+        res += SizeHelper::MAP_NODE_OVERHEAD + sizeof( e ) + e.second->get_memory_usage();
+    }
+
+    for( auto & e : map_id_to_temp_variable_ )
+    {
+        res += SizeHelper::MAP_NODE_OVERHEAD + sizeof( e ) + e.second->get_memory_usage();
+    }
+
+    for( auto & e : map_id_to_constant_ )
+    {
+        res += SizeHelper::MAP_NODE_OVERHEAD + sizeof( e ) + e.second->get_memory_usage();
+    }
+
+    return res;
+}
+
 } // namespace fsm
@@ -25,6 +25,10 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #define LIB_FSM__MEMORY_H
 
 #include <map>                  // std::map
+#include <ostream>              // std::ostream
+#include <istream>              // std::istream
+#include <functional>           // std::function
+#include <memory>               // std::unique_ptr
 
 #include "utils/request_id_gen.h"   // utils::RequestIdGen
 
@@ -33,12 +37,17 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include "signal.h"             // Signal
 #include "expression.h"         // Expression
 #include "names_db.h"           // NamesDb
+#include "string_pool.h"        // StringPool
 
 namespace fsm {
 
+// maps names of elements of a saved process to the names in another definition, empty name drops the element
+typedef std::function<std::string( const std::string & name )> NameMapper;
+
 class Memory
 {
     friend class SdlGrHelper;
+    friend class CppGenHelper;
 
 public:
     Memory(
@@ -52,6 +61,16 @@ public:
     element_id_t create_add_variable( const std::string & name, data_type_e type, const Value & value );
     element_id_t create_add_constant( const std::string & name, data_type_e type, const Value & value );
 
+    void reset( uint32_t id );
+
+    // optional, string values of variables and constants created afterwards are interned
+    void set_string_pool( StringPool * string_pool );
+
+    // runtime errors of the evaluation are kept instead of thrown, the first one is reported by get_error()
+    void set_exception_free( bool is_exception_free );
+    bool has_error() const;
+    const std::string & get_error() const;
+
     void clear_temp_variables();
     void init_temp_variables_from_signal( const ev::Signal & s, std::vector<element_id_t> * arguments );
     element_id_t create_temp_variable( const Value & v, unsigned n );
@@ -69,12 +88,33 @@ public:
     void import_value_into_variable( const std::string & variable_name, const Value & value );
     void import_value_into_variable( element_id_t variable_id, const Value & value );
 
+    // expression consists of values and constants only
+    bool is_constant_expression( const Expression & expr ) const;
+
+    // returns the type of the expression if it is known statically, stores operand types and typed operations in its operators,
+    // throws SyntaxError on a type mismatch
+    data_type_e check_types( Expression & expr );
+    data_type_e get_element_type( element_id_t id ) const;
+
+    // int and double are converted into each other
+    static bool is_numeric( data_type_e type );
+
     void evaluate_expression( Value * value, ExpressionPtr expr );
     void evaluate_expression( Value * value, const Expression & expr );
 
+    // stored value of a literal, a variable or a constant without copying, nullptr for other expressions
+    const CompactValue * find_compact_value( const Expression & expr ) const;
+
+    void save( std::ostream & os ) const;
+    void save_changed( std::ostream & os );
+    bool load( std::istream & is, const NameMapper & mapper, std::string * error_msg );
+
+    // bytes allocated by the memory, excluding the object itself
+    std::size_t get_memory_usage() const;
+
 private:
-    typedef std::map<element_id_t,Variable*>        MapIdToVariable;
-    typedef std::map<element_id_t,Constant*>        MapIdToConstant;
+    typedef std::map<element_id_t,std::unique_ptr<Variable>>    MapIdToVariable;
+    typedef std::map<element_id_t,std::unique_ptr<Constant>>    MapIdToConstant;
 
 private:
     Memory( const Memory & )              = delete;
@@ -82,8 +122,13 @@ private:
 
     element_id_t create_add_variable_core( const std::string & name, data_type_e type, const Value & value, bool is_inited );
 
+    CompactValue make_compact_value( data_type_e type, const Value & value ) const;
+
     void convert_variable_to_value( Value * value, element_id_t variable_id );
 
+    // throws SyntaxError or keeps the error in the exception-free mode
+    void raise_error( const std::string & error );
+
     void evaluate_expression_ExpressionValue( Value * value, const Expression & expr );
     void evaluate_expression_ExpressionVariable( Value * value, const Expression & expr );
     void evaluate_expression_ExpressionVariableName( Value * value, const Expression & expr );
@@ -98,6 +143,10 @@ private:
     uint32_t                    log_id_;
     utils::IRequestIdGen        * req_id_gen_;
     NamesDb                     * names_;
+    StringPool                  * string_pool_;
+
+    bool                        is_exception_free_;
+    std::string                 error_;
 
     MapIdToVariable             map_id_to_variable_;
     MapIdToVariable             map_id_to_temp_variable_;
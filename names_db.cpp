@@ -28,6 +28,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include "utils/dummy_logger.h"     // dummy_log_debug
 
 #include "syntax_error.h"           // SyntaxError
+#include "size_helper.h"            // SizeHelper
 
 namespace fsm {
 
@@ -97,4 +98,26 @@ bool NamesDb::delete_name( element_id_t id )
     return true;
 }
 
+void NamesDb::set_id( uint32_t id )
+{
+    id_ = id;
+}
+
+std::size_t NamesDb::get_memory_usage() const
+{
+    std::size_t res = 0;
+
+    for( auto & e : map_id_to_name_ )
+    {
+        res += SizeHelper::MAP_NODE_OVERHEAD + sizeof( e ) + SizeHelper::get_size( e.second );
+    }
+
+    for( auto & e : map_name_to_id_ )
+    {
+        res += SizeHelper::MAP_NODE_OVERHEAD + sizeof( e ) + SizeHelper::get_size( e.first );
+    }
+
+    return res;
+}
+
 } // namespace fsm
@@ -43,6 +43,11 @@ public:
     element_id_t find_element( const std::string & name ) const;
     bool delete_name( element_id_t id );
 
+    void set_id( uint32_t id );
+
+    // excluding the object itself
+    std::size_t get_memory_usage() const;
+
 private:
     typedef std::map<element_id_t,std::string>      MapIdToString;
     typedef std::map<std::string,element_id_t>      MapStringToId;
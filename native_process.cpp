@@ -0,0 +1,344 @@
+/*
+
+FSM. Base of processes compiled to C++.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11636 $ $Date:: 2019-06-05 #$ $Author: serge $
+
+#include "native_process.h"     // self
+
+#include <cassert>              // assert
+
+#include "utils/dummy_logger.h"     // dummy_logi_debug
+#include "scheduler/timeout_job_aux.h"      // create_and_insert_timeout_job
+#include "anyvalue/value_operations.h"      // compare_values
+
+#include "syntax_error.h"           // SyntaxError
+
+namespace fsm {
+
+NativeProcess::NativeProcess(
+        uint32_t                id,
+        uint32_t                log_id,
+        IFsm                    * parent,
+        ICallback               * callback,
+        scheduler::IScheduler   * scheduler ):
+        id_( id ),
+        log_id_( log_id ),
+        parent_( parent ),
+        callback_( callback ),
+        scheduler_( scheduler ),
+        is_ended_( false )
+{
+    dummy_logi_info( log_id_, id_, "created" );
+}
+
+NativeProcess::~NativeProcess()
+{
+    // armed timers would fire for the id of the destructed process
+    for( auto & e : map_id_to_timer_ )
+    {
+        reset_timer( e.first );
+    }
+
+    dummy_logi_info( log_id_, id_, "destructed" );
+}
+
+void NativeProcess::handle( const ev::Signal & req )
+{
+    if( is_ended_ )
+    {
+        dummy_logi_info( log_id_, id_, "process finished, ignoring" );
+        return;
+    }
+
+    arguments_  = req.arguments;
+
+    handle_signal_intern( req.name );
+}
+
+void NativeProcess::handle( const ev::Timer & req )
+{
+    if( is_ended_ )
+    {
+        dummy_logi_info( log_id_, id_, "process finished, ignoring" );
+        return;
+    }
+
+    auto it = map_id_to_timer_.find( req.timer_id );
+
+    if( it == map_id_to_timer_.end() )
+    {
+        dummy_logi_info( log_id_, id_, "unknown timer %u, ignoring", req.timer_id );
+        return;
+    }
+
+    if( it->second.job_id == 0 )
+    {
+        dummy_logi_info( log_id_, id_, "timer %u is already cancelled", req.timer_id );
+        return;
+    }
+
+    it->second.job_id   = 0;
+
+    arguments_.clear();
+
+    handle_signal_intern( it->second.name );
+}
+
+void NativeProcess::handle_signal_intern( const std::string & name )
+{
+    if( handle_signal( name ) == false )
+    {
+        dummy_logi_info( log_id_, id_, "signal %s - not handled", name.c_str() );
+    }
+}
+
+bool NativeProcess::is_ended() const
+{
+    return is_ended_;
+}
+
+void NativeProcess::add_timer( element_id_t timer_id, const std::string & name )
+{
+    auto b = map_id_to_timer_.insert( std::make_pair( timer_id, TimerSlot { name, 0 } ) ).second;
+
+    assert( b );(void)b;
+}
+
+NativeProcess::TimerSlot & NativeProcess::get_timer( element_id_t timer_id )
+{
+    auto it = map_id_to_timer_.find( timer_id );
+
+    if( it == map_id_to_timer_.end() )
+    {
+        dummy_logi_fatal( log_id_, id_, "cannot find timer %u", timer_id );
+        assert( 0 );
+        throw SyntaxError( "cannot find timer " + std::to_string( timer_id ) );
+    }
+
+    return it->second;
+}
+
+void NativeProcess::set_timer( element_id_t timer_id, double delay )
+{
+    auto & timer = get_timer( timer_id );
+
+    if( timer.job_id != 0 )
+    {
+        dummy_logi_fatal( log_id_, id_, "timer id %u is active (job id %u)", timer_id, timer.job_id );
+        assert( 0 );
+        throw SyntaxError( "timer " + std::to_string( timer_id ) + " is active (job id " + std::to_string( timer.job_id ) + ")" );
+    }
+
+    std::string error_msg;
+
+    auto parent     = parent_;
+    auto process_id = id_;
+
+    auto b = scheduler::create_and_insert_timeout_job(
+            & timer.job_id,
+            & error_msg,
+            * scheduler_,
+            "timer_job",
+            scheduler::Duration( delay ),
+            [parent, process_id, timer_id]() { parent->consume( new ev::Timer( process_id, timer_id, 0 ) ); } );
+
+    if( b == false )
+    {
+        dummy_logi_error( log_id_, id_, "cannot set timer: %s", error_msg.c_str() );
+
+        timer.job_id    = 0;
+    }
+    else
+    {
+        dummy_logi_debug( log_id_, id_, "timer %s, scheduled execution in: %.2f sec", timer.name.c_str(), delay );
+    }
+}
+
+void NativeProcess::reset_timer( element_id_t timer_id )
+{
+    auto & timer = get_timer( timer_id );
+
+    if( timer.job_id == 0 )
+        return;
+
+    std::string error_msg;
+
+    if( scheduler_->delete_job( & error_msg, timer.job_id ) == false )
+    {
+        dummy_logi_error( log_id_, id_, "cannot reset timer: %s", error_msg.c_str() );
+    }
+
+    timer.job_id    = 0;
+}
+
+void NativeProcess::send_signal( const std::string & name, const std::vector<Value> & arguments )
+{
+    callback_->handle_send_signal( id_, name, arguments );
+}
+
+void NativeProcess::call_function( const std::string & name, std::vector<Value> * arguments )
+{
+    std::vector<Value*> value_pointers;
+
+    for( auto & e : * arguments )
+    {
+        value_pointers.push_back( & e );
+    }
+
+    callback_->handle_function_call( id_, name, value_pointers );
+}
+
+const Value & NativeProcess::get_argument( unsigned n ) const
+{
+    if( n == 0 || n > arguments_.size() )
+    {
+        dummy_logi_fatal( log_id_, id_, "signal argument $%u not found, signal has %u arguments", n, unsigned( arguments_.size() ) );
+        throw SyntaxError( "signal argument $" + std::to_string( n ) + " not found" );
+    }
+
+    return arguments_[ n - 1 ];
+}
+
+void NativeProcess::set_argument( unsigned n, const Value & value )
+{
+    get_argument( n );
+
+    arguments_[ n - 1 ]  = value;
+}
+
+void NativeProcess::set_ended()
+{
+    is_ended_   = true;
+}
+
+Value NativeProcess::to_value( bool v )
+{
+    Value res;
+
+    res.type    = data_type_e::BOOL;
+    res.arg_b   = v;
+
+    return res;
+}
+
+Value NativeProcess::to_value( int64_t v )
+{
+    Value res;
+
+    res.type    = data_type_e::INT;
+    res.arg_i   = v;
+
+    return res;
+}
+
+Value NativeProcess::to_value( double v )
+{
+    Value res;
+
+    res.type    = data_type_e::DOUBLE;
+    res.arg_d   = v;
+
+    return res;
+}
+
+Value NativeProcess::to_value( const std::string & v )
+{
+    Value res;
+
+    res.type    = data_type_e::STRING;
+    res.arg_s   = v;
+
+    return res;
+}
+
+Value NativeProcess::to_value( const char * v )
+{
+    return to_value( std::string( v ) );
+}
+
+bool NativeProcess::to_bool( const Value & v )
+{
+    Value res;
+
+    res.type    = data_type_e::BOOL;
+
+    anyvalue::assign( & res, v );
+
+    return res.arg_b;
+}
+
+int64_t NativeProcess::to_int( const Value & v )
+{
+    Value res;
+
+    res.type    = data_type_e::INT;
+
+    anyvalue::assign( & res, v );
+
+    return res.arg_i;
+}
+
+double NativeProcess::to_double( const Value & v )
+{
+    Value res;
+
+    res.type    = data_type_e::DOUBLE;
+
+    anyvalue::assign( & res, v );
+
+    return res.arg_d;
+}
+
+std::string NativeProcess::to_string( const Value & v )
+{
+    Value res;
+
+    res.type    = data_type_e::STRING;
+
+    anyvalue::assign( & res, v );
+
+    return res.arg_s;
+}
+
+Value NativeProcess::unary_operation( unary_operation_type_e type, const Value & op )
+{
+    Value res;
+
+    anyvalue::unary_operation( & res, type, op );
+
+    return res;
+}
+
+Value NativeProcess::binary_operation( binary_operation_type_e type, const Value & lhs, const Value & rhs )
+{
+    Value res;
+
+    anyvalue::binary_operation( & res, type, lhs, rhs );
+
+    return res;
+}
+
+bool NativeProcess::compare_values( comparison_type_e type, const Value & lhs, const Value & rhs )
+{
+    return anyvalue::compare_values( type, lhs, rhs );
+}
+
+} // namespace fsm
@@ -0,0 +1,137 @@
+/*
+
+FSM. Base of processes compiled to C++.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11636 $ $Date:: 2019-06-05 #$ $Author: serge $
+
+#ifndef LIB_FSM__NATIVE_PROCESS_H
+#define LIB_FSM__NATIVE_PROCESS_H
+
+#include <map>                  // std::map
+#include <vector>               // std::vector
+#include <functional>           // std::function
+
+#include "scheduler/i_scheduler.h"  // IScheduler
+#include "scheduler/job_id_t.h"     // scheduler::job_id_t
+
+#include "elements.h"           // Value
+#include "signal.h"             // Signal
+#include "objects.h"            // ev::Timer
+#include "i_fsm.h"              // IFsm
+#include "i_callback.h"         // ICallback
+
+namespace fsm {
+
+// process implemented in C++, e.g. generated by CppGenHelper, the base provides timers, signal arguments and the callback
+class NativeProcess
+{
+public:
+
+    typedef std::function<NativeProcess*( uint32_t id, uint32_t log_id, IFsm * parent, ICallback * callback, scheduler::IScheduler * scheduler )> Factory;
+
+public:
+    NativeProcess(
+            uint32_t                id,
+            uint32_t                log_id,
+            IFsm                    * parent,
+            ICallback               * callback,
+            scheduler::IScheduler   * scheduler );
+    virtual ~NativeProcess();
+
+    virtual void start() = 0;
+
+    void handle( const ev::Signal & req );
+    void handle( const ev::Timer & req );
+
+    bool is_ended() const;
+
+protected:
+
+    // returns false if the signal is not handled in the current state, arguments are available via get_argument()
+    virtual bool handle_signal( const std::string & name ) = 0;
+
+    void add_timer( element_id_t timer_id, const std::string & name );
+    void set_timer( element_id_t timer_id, double delay );
+    void reset_timer( element_id_t timer_id );
+
+    void send_signal( const std::string & name, const std::vector<Value> & arguments );
+    void call_function( const std::string & name, std::vector<Value> * arguments );
+
+    // arguments of the current signal, numbered from 1 like $1, $2, ...
+    const Value & get_argument( unsigned n ) const;
+    void set_argument( unsigned n, const Value & value );
+
+    void set_ended();
+
+    static Value to_value( bool v );
+    static Value to_value( int64_t v );
+    static Value to_value( double v );
+    static Value to_value( const std::string & v );
+    static Value to_value( const char * v );
+
+    // conversion with the rules of the interpreter, i.e. of anyvalue::assign()
+    static bool to_bool( const Value & v );
+    static int64_t to_int( const Value & v );
+    static double to_double( const Value & v );
+    static std::string to_string( const Value & v );
+
+    static Value unary_operation( unary_operation_type_e type, const Value & op );
+    static Value binary_operation( binary_operation_type_e type, const Value & lhs, const Value & rhs );
+    static bool compare_values( comparison_type_e type, const Value & lhs, const Value & rhs );
+
+private:
+
+    struct TimerSlot
+    {
+        std::string             name;
+        scheduler::job_id_t     job_id;
+    };
+
+    typedef std::map<element_id_t,TimerSlot>    MapIdToTimer;
+
+private:
+    NativeProcess( const NativeProcess & )              = delete;
+    NativeProcess & operator=( const NativeProcess & )  = delete;
+
+    TimerSlot & get_timer( element_id_t timer_id );
+
+    void handle_signal_intern( const std::string & name );
+
+protected:
+
+    uint32_t                    id_;
+    uint32_t                    log_id_;
+
+private:
+
+    IFsm                        * parent_;
+    ICallback                   * callback_;
+    scheduler::IScheduler       * scheduler_;
+
+    bool                        is_ended_;
+
+    std::vector<Value>          arguments_;
+
+    MapIdToTimer                map_id_to_timer_;
+};
+
+} // namespace fsm
+
+#endif // LIB_FSM__NATIVE_PROCESS_H
@@ -44,14 +44,21 @@ struct StartProcess: public Object
 
 struct Timer: public Object
 {
-    Timer( uint32_t process_id, element_id_t timer_id ):
+    Timer( uint32_t process_id, element_id_t timer_id, uint32_t epoch ):
         process_id( process_id ),
-        timer_id( timer_id )
+        timer_id( timer_id ),
+        epoch( epoch )
     {
     }
 
     uint32_t                        process_id;
     element_id_t                    timer_id;
+    // of the process instance that set the timer, a migrated process has a new one
+    uint32_t                        epoch;
+};
+
+struct FlushJournal: public Object
+{
 };
 
 } // namespace ev
@@ -19,7 +19,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-// $Revision: 11612 $ $Date:: 2019-05-24 #$ $Author: serge $
+// $Revision: 11668 $ $Date:: 2019-06-21 #$ $Author: serge $
 
 #include "process.h"            // self
 
@@ -27,6 +27,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include <typeindex>            // std::type_index
 #include <typeinfo>
 #include <unordered_map>
+#include <chrono>               // std::chrono::system_clock, std::chrono::steady_clock
 
 #include "utils/dummy_logger.h"     // dummy_logi_debug
 #include "scheduler/timeout_job_aux.h"      // create_and_insert_timeout_job
@@ -35,9 +36,15 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include "str_helper.h"             // StrHelper
 #include "syntax_error.h"           // SyntaxError
+#include "flight_recorder.h"        // FlightRecorder
+#include "serializer.h"             // Serializer
+#include "size_helper.h"            // SizeHelper
+#include "typed_operations.h"       // TypedOperations
 
 namespace fsm {
 
+const uint32_t SNAPSHOT_VERSION     = 4;
+
 Process::Process(
         uint32_t                id,
         uint32_t                log_id,
@@ -46,15 +53,24 @@ Process::Process(
         scheduler::IScheduler   * scheduler ):
         id_( id ),
         log_id_( log_id ),
+        parent_process_id_( 0 ),
+        epoch_( 0 ),
         parent_( parent ),
         callback_( callback ),
         scheduler_( scheduler ),
         internal_state_( internal_state_e::IDLE ),
         current_state_( 0 ),
+        initial_state_( 0 ),
         start_action_connector_( 0 ),
         matched_switch_condition_( 0 ),
+        is_finalized_( false ),
+        is_exception_free_( false ),
+        saved_signals_head_( nullptr ),
+        saved_signals_tail_( nullptr ),
+        is_state_changed_( false ),
         names_( id, log_id ),
-        mem_( id, log_id, & req_id_gen_, & names_ )
+        mem_( id, log_id, & req_id_gen_, & names_ ),
+        profile_( nullptr )
 
 {
     req_id_gen_.init( 1, 1 );
@@ -64,10 +80,10 @@ Process::Process(
 
 Process::~Process()
 {
-    for( auto & e : map_id_to_state_ )
-    {
-        delete e.second;
-    }
+    // armed timers would fire for the id of the destructed process
+    reset_timers();
+
+    clear_saved_signals();
 
     dummy_logi_info( log_id_, id_, "destructed" );
 }
@@ -78,17 +94,17 @@ void Process::start()
 
     assert( internal_state_ == internal_state_e::IDLE );
 
+    // validates the start action connector
+    finalize();
+
     internal_state_ = internal_state_e::ACTIVE;
 
     dummy_logi_debug( log_id_, id_, "start: start_action_connector %u", start_action_connector_ );
 
-    if( start_action_connector_ == 0 )
-    {
-        dummy_logi_fatal( log_id_, id_, "start: start_action_connector is not set" );
-        throw SyntaxError( "start: start_action_connector is not set" );
-    }
-
     execute_action_connector_id( start_action_connector_ );
+
+    // nothing is saved yet, clears the state change
+    handle_saved_signals();
 }
 
 void Process::handle_signal_handler( element_id_t signal_handler_id, const std::vector<element_id_t> & arguments )
@@ -100,20 +116,30 @@ void Process::handle_signal_handler( element_id_t signal_handler_id, const std::
     if( it == map_id_to_signal_handler_.end() )
     {
         dummy_logi_fatal( log_id_, id_, "handle_signal_handler: cannot find signal handler id %u", signal_handler_id );
-        throw SyntaxError( "signal handler id " + std::to_string( signal_handler_id ) + " not found" );
+        raise_error( "signal handler id " + std::to_string( signal_handler_id ) + " not found" );
+        terminate( get_error() );
         return;
     }
 
+    FlightRecorder::record( FlightRecorder::event_type_e::SIGNAL_HANDLER, id_, current_state_, signal_handler_id, 0 );
+
     auto & h = it->second;
 
     auto first_action_id = h->get_first_action_id();
 
     dummy_logi_debug( log_id_, id_, "handle_signal_handler: signal handler id %u, first action id %u", signal_handler_id, first_action_id );
 
+    auto begin = profile_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
     if( first_action_id )
     {
         execute_action_connector_id( first_action_id );
     }
+
+    if( profile_ )
+    {
+        profile_->add_signal_handler( signal_handler_id, std::chrono::steady_clock::now() - begin );
+    }
 }
 
 bool Process::is_ended() const
@@ -121,6 +147,44 @@ bool Process::is_ended() const
     return internal_state_ == internal_state_e::FINISHED;
 }
 
+void Process::set_exception_free( bool is_exception_free )
+{
+    is_exception_free_  = is_exception_free;
+
+    mem_.set_exception_free( is_exception_free );
+}
+
+bool Process::has_error() const
+{
+    return error_.empty() == false || mem_.has_error();
+}
+
+const std::string & Process::get_error() const
+{
+    return error_.empty() ? mem_.get_error() : error_;
+}
+
+void Process::terminate( const std::string & error )
+{
+    if( error_.empty() )
+        error_  = error;
+
+    dummy_logi_error( log_id_, id_, "terminated: %s", error_.c_str() );
+
+    reset_timers();
+
+    internal_state_ = internal_state_e::FINISHED;
+}
+
+void Process::raise_error( const std::string & error )
+{
+    if( is_exception_free_ == false )
+        throw SyntaxError( error );
+
+    if( error_.empty() )
+        error_  = error;
+}
+
 element_id_t Process::create_add_start_action_connector( Action * action )
 {
     if( start_action_connector_ != 0 )
@@ -142,9 +206,9 @@ element_id_t Process::create_state( const std::string & name )
 {
     auto id = get_next_id();
 
-    auto state = new State( log_id_, id, id_, name, this );
+    std::unique_ptr<State> state( new State( log_id_, id, id_, name, this ) );
 
-    auto b = map_id_to_state_.insert( std::make_pair( id, state ) ).second;
+    auto b = map_id_to_state_.insert( std::make_pair( id, std::move( state ) ) ).second;
 
     assert( b );
 
@@ -177,6 +241,21 @@ element_id_t Process::create_add_signal_handler( element_id_t state_id, const st
     return id;
 }
 
+void Process::add_saved_signal( element_id_t state_id, const std::string & signal_name )
+{
+    dummy_logi_trace( log_id_, id_, "add_saved_signal: state id %u, signal name %s", state_id, signal_name.c_str() );
+
+    auto state = find_state( state_id );
+
+    if( state == nullptr )
+    {
+        dummy_logi_fatal( log_id_, id_, "add_saved_signal: cannot find state id %u", state_id );
+        throw SyntaxError( "state id " + std::to_string( state_id ) + " not found" );
+    }
+
+    state->add_saved_signal( signal_name );
+}
+
 void Process::set_first_action_connector( element_id_t signal_handler_id, element_id_t action_connector_id )
 {
     dummy_logi_trace( log_id_, id_, "set_first_action_connector: signal handler id %u, action_connector_id %u", signal_handler_id, action_connector_id );
@@ -294,9 +373,9 @@ element_id_t Process::create_add_timer( const std::string & name )
 {
     auto id = get_next_id();
 
-    auto timer = new Timer( log_id_, id, name );
+    std::unique_ptr<Timer> timer( new Timer( log_id_, id, name ) );
 
-    auto b = map_id_to_timer_.insert( std::make_pair( id, timer ) ).second;
+    auto b = map_id_to_timer_.insert( std::make_pair( id, std::move( timer ) ) ).second;
 
     assert( b );
 
@@ -311,9 +390,9 @@ element_id_t Process::create_signal_handler( const std::string & name )
 {
     auto id = get_next_id();
 
-    auto signal_handler = new SignalHandler( log_id_, id, name );
+    std::unique_ptr<SignalHandler> signal_handler( new SignalHandler( log_id_, id, name ) );
 
-    auto b = map_id_to_signal_handler_.insert( std::make_pair( id, signal_handler ) ).second;
+    auto b = map_id_to_signal_handler_.insert( std::make_pair( id, std::move( signal_handler ) ) ).second;
 
     assert( b );
 
@@ -328,99 +407,1037 @@ element_id_t Process::create_action_connector( Action * action )
 {
     auto id = get_next_id();
 
-    auto obj = new ActionConnector( log_id_, id, action );
+    std::unique_ptr<ActionConnector> obj( new ActionConnector( log_id_, id, action ) );
+
+    auto b = map_id_to_action_connector_.insert( std::make_pair( id, std::move( obj ) ) ).second;
+
+    assert( b );
+
+    dummy_logi_debug( log_id_, id_, "create_action_connector: created action connector %u", id );
+
+    return id;
+}
+
+element_id_t Process::create_add_variable( const std::string & name, data_type_e type )
+{
+    return mem_.create_add_variable( name, type );
+}
+
+element_id_t Process::create_add_variable( const std::string & name, data_type_e type, const Value & value )
+{
+    return mem_.create_add_variable( name, type, value );
+}
+
+element_id_t Process::create_add_constant( const std::string & name, data_type_e type, const Value & value )
+{
+    return mem_.create_add_constant( name, type, value );
+}
+
+void Process::set_initial_state( element_id_t state_id )
+{
+    dummy_logi_trace( log_id_, id_, "set_initial_state: %u", state_id );
+
+    assert( current_state_ == 0 );
+
+    current_state_  = state_id;
+    initial_state_  = state_id;
+}
+
+void Process::add_coalesced_signal( const std::string & signal_name )
+{
+    dummy_logi_debug( log_id_, id_, "add_coalesced_signal: %s", signal_name.c_str() );
+
+    coalesced_signals_.insert( signal_name );
+}
+
+const std::set<std::string> & Process::get_coalesced_signals() const
+{
+    return coalesced_signals_;
+}
+
+void Process::finalize()
+{
+    if( is_finalized_ )
+        return;
+
+    auto num_pruned = prune_unreachable_elements();
+
+    // unreachable elements may be incomplete, they are removed before
+    validate();
+
+    unsigned num_cached = 0;
+    unsigned num_tables = 0;
+
+    for( auto & e : map_id_to_action_connector_ )
+    {
+        auto action = e.second->get_action();
+
+        if( action == nullptr )
+            continue;
+
+        check_types( * action );
+
+        if( typeid( * action ) == typeid( SendSignal ) )
+        {
+            auto & a = dynamic_cast< SendSignal &>( * action );
+
+            // arguments of local signals are moved
+            if( a.target == SendSignal::target_e::ENV )
+                a.cache = create_argument_cache( a.arguments );
+
+            num_cached += a.cache ? 1 : 0;
+        }
+        else if( typeid( * action ) == typeid( FunctionCall ) )
+        {
+            auto & a = dynamic_cast< FunctionCall &>( * action );
+
+            a.cache = create_argument_cache( a.arguments );
+
+            num_cached += a.cache ? 1 : 0;
+        }
+        else if( typeid( * action ) == typeid( SwitchCondition ) )
+        {
+            auto & a = dynamic_cast< SwitchCondition &>( * action );
+
+            a.table = create_switch_table( a.values );
+
+            num_tables += a.table ? 1 : 0;
+        }
+    }
+
+    is_finalized_ = true;
+
+    dummy_logi_debug( log_id_, id_, "finalize: %u unreachable elements removed, %u argument lists precomputed, %u switch tables", num_pruned, num_cached, num_tables );
+}
+
+void Process::validate()
+{
+    if( start_action_connector_ == 0 )
+        throw_validation_error( "start action connector is not set" );
+
+    if( find_action_connector( start_action_connector_ ) == nullptr )
+        throw_validation_error( "start action connector " + std::to_string( start_action_connector_ ) + " not found" );
+
+    if( initial_state_ != 0 && find_state( initial_state_ ) == nullptr )
+        throw_validation_error( "initial state " + std::to_string( initial_state_ ) + " not found" );
+
+    for( auto & e : map_id_to_state_ )
+    {
+        for( auto & h : e.second->map_signal_name_to_signal_handler_ids_ )
+        {
+            if( map_id_to_signal_handler_.count( h.second ) == 0 )
+                throw_validation_error( "state " + e.second->get_name() + ": signal handler " + std::to_string( h.second ) + " not found" );
+        }
+    }
+
+    for( auto & e : map_id_to_signal_handler_ )
+    {
+        auto first_action_id = e.second->get_first_action_id();
+
+        // empty handler is allowed
+        if( first_action_id != 0 && find_action_connector( first_action_id ) == nullptr )
+            throw_validation_error( "signal handler " + std::to_string( e.first ) + ": first action connector " + std::to_string( first_action_id ) + " not found" );
+    }
+
+    for( auto & e : map_id_to_action_connector_ )
+    {
+        validate( * e.second );
+    }
+}
+
+void Process::validate( ActionConnector & action_connector )
+{
+    auto id     = std::to_string( action_connector.get_id() );
+    auto action = action_connector.get_action();
+
+    if( action == nullptr )
+        throw_validation_error( "action connector " + id + ": action is not set" );
+
+    if( typeid( * action ) == typeid( Exit ) )
+        return;
+
+    if( typeid( * action ) == typeid( NextState ) )
+    {
+        auto & a = dynamic_cast< NextState &>( * action );
+
+        if( find_state( a.state_id ) == nullptr )
+            throw_validation_error( "action connector " + id + ": state " + std::to_string( a.state_id ) + " not found" );
+
+        return;
+    }
+
+    if( typeid( * action ) == typeid( SwitchCondition ) )
+    {
+        auto & a = dynamic_cast< SwitchCondition &>( * action );
+
+        auto & actions = action_connector.get_switch_actions();
+
+        if( actions.size() != a.values.size() )
+            throw_validation_error( "action connector " + id + ": " + std::to_string( actions.size() ) + " switch actions for "
+                    + std::to_string( a.values.size() ) + " values" );
+
+        validate_next( action_connector, action_connector.get_default_switch_action(), "default switch action" );
+
+        for( auto e : actions )
+        {
+            validate_next( action_connector, e, "switch action" );
+        }
+
+        return;
+    }
+
+    validate_next( action_connector, action_connector.get_next_id(), "next action" );
+
+    if( typeid( * action ) == typeid( Condition ) )
+    {
+        validate_next( action_connector, action_connector.get_alt_next_id(), "alternative next action" );
+    }
+    else if( typeid( * action ) == typeid( SetTimer ) )
+    {
+        auto & a = dynamic_cast< SetTimer &>( * action );
+
+        a.timer = find_timer( a.timer_id );
+
+        if( a.timer == nullptr )
+            throw_validation_error( "action connector " + id + ": timer " + std::to_string( a.timer_id ) + " not found" );
+    }
+    else if( typeid( * action ) == typeid( ResetTimer ) )
+    {
+        auto & a = dynamic_cast< ResetTimer &>( * action );
+
+        a.timer = find_timer( a.timer_id );
+
+        if( a.timer == nullptr )
+            throw_validation_error( "action connector " + id + ": timer " + std::to_string( a.timer_id ) + " not found" );
+    }
+    else if( typeid( * action ) == typeid( Task ) )
+    {
+        auto & a = dynamic_cast< Task &>( * action );
+
+        a.variable = mem_.find_variable( a.variable_id );
+
+        if( a.variable == nullptr )
+            throw_validation_error( "action connector " + id + ": variable " + std::to_string( a.variable_id ) + " not found" );
+    }
+    else if( typeid( * action ) == typeid( SendSignal ) )
+    {
+        auto & a = dynamic_cast< SendSignal &>( * action );
+
+        if( a.target == SendSignal::target_e::PROCESS && a.to == nullptr )
+            throw_validation_error( "action connector " + id + ": process id of signal " + a.name + " is not set" );
+    }
+    else if( typeid( * action ) != typeid( FunctionCall ) )
+    {
+        throw_validation_error( "action connector " + id + ": unsupported action " + typeid( * action ).name() );
+    }
+}
+
+void Process::validate_next( const ActionConnector & action_connector, element_id_t next_id, const char * kind )
+{
+    if( next_id == 0 )
+        throw_validation_error( "action connector " + std::to_string( action_connector.get_id() ) + ": " + kind + " is not set" );
+
+    if( find_action_connector( next_id ) == nullptr )
+        throw_validation_error( "action connector " + std::to_string( action_connector.get_id() ) + ": " + kind + " " + std::to_string( next_id ) + " not found" );
+}
+
+void Process::throw_validation_error( const std::string & error ) const
+{
+    dummy_logi_fatal( log_id_, id_, "finalize: %s", error.c_str() );
+
+    throw SyntaxError( error );
+}
+
+unsigned Process::prune_unreachable_elements()
+{
+    // definition is incomplete, start() will fail anyway
+    if( start_action_connector_ == 0 )
+        return 0;
+
+    std::set<element_id_t>      reachable;
+    std::vector<element_id_t>   pending     = { start_action_connector_, initial_state_ };
+
+    while( pending.empty() == false )
+    {
+        auto id = pending.back();
+
+        pending.pop_back();
+
+        if( id == 0 || reachable.insert( id ).second == false )
+            continue;
+
+        add_successors( & pending, id );
+    }
+
+    return prune( & map_id_to_state_, reachable, "state" )
+            + prune( & map_id_to_signal_handler_, reachable, "signal handler" )
+            + prune( & map_id_to_action_connector_, reachable, "action connector" );
+}
+
+void Process::add_successors( std::vector<element_id_t> * ids, element_id_t id ) const
+{
+    auto it_state = map_id_to_state_.find( id );
+
+    if( it_state != map_id_to_state_.end() )
+    {
+        for( auto & e : it_state->second->map_signal_name_to_signal_handler_ids_ )
+        {
+            ids->push_back( e.second );
+        }
+
+        return;
+    }
+
+    auto it_handler = map_id_to_signal_handler_.find( id );
+
+    if( it_handler != map_id_to_signal_handler_.end() )
+    {
+        ids->push_back( it_handler->second->get_first_action_id() );
+
+        return;
+    }
+
+    auto action_connector = find_action_connector( id );
+
+    if( action_connector == nullptr )
+        return;
+
+    ids->push_back( action_connector->get_next_id() );
+    ids->push_back( action_connector->get_alt_next_id() );
+    ids->push_back( action_connector->get_default_switch_action() );
+
+    for( auto e : action_connector->get_switch_actions() )
+    {
+        ids->push_back( e );
+    }
+
+    auto action = action_connector->get_action();
+
+    if( action && typeid( * action ) == typeid( NextState ) )
+    {
+        ids->push_back( dynamic_cast< const NextState &>( * action ).state_id );
+    }
+}
+
+template<class MAP>
+unsigned Process::prune( MAP * map, const std::set<element_id_t> & reachable, const char * kind )
+{
+    unsigned res = 0;
+
+    for( auto it = map->begin(); it != map->end(); )
+    {
+        if( reachable.count( it->first ) )
+        {
+            ++it;
+            continue;
+        }
+
+        dummy_logi_warn( log_id_, id_, "finalize: unreachable %s %s (%u) removed", kind, names_.get_name( it->first ).c_str(), it->first );
+
+        names_.delete_name( it->first );
+
+        it = map->erase( it );
+
+        ++res;
+    }
+
+    return res;
+}
+
+ArgumentCachePtr Process::create_argument_cache( const std::vector<ExpressionPtr> & arguments )
+{
+    ArgumentCachePtr res( new ArgumentCache );
+
+    res->values.resize( arguments.size() );
+
+    unsigned num_constant = 0;
+
+    for( unsigned i = 0; i < arguments.size(); ++i )
+    {
+        if( mem_.is_constant_expression( * arguments[i] ) )
+        {
+            mem_.evaluate_expression( & res->values[i], arguments[i] );
+
+            ++num_constant;
+        }
+        else
+        {
+            res->variable_slots.push_back( i );
+        }
+    }
+
+    if( num_constant == 0 && arguments.empty() == false )
+        return ArgumentCachePtr();
+
+    return res;
+}
+
+ArgumentCachePtr Process::create_argument_cache( const std::vector<std::pair<bool,ExpressionPtr>> & arguments )
+{
+    ArgumentCachePtr res( new ArgumentCache );
+
+    res->values.resize( arguments.size() );
+
+    unsigned num_constant = 0;
+
+    for( unsigned i = 0; i < arguments.size(); ++i )
+    {
+        // output arguments are always variables
+        if( arguments[i].first == false && mem_.is_constant_expression( * arguments[i].second ) )
+        {
+            mem_.evaluate_expression( & res->values[i], arguments[i].second );
+
+            ++num_constant;
+        }
+        else
+        {
+            res->variable_slots.push_back( i );
+        }
+    }
+
+    if( num_constant == 0 && arguments.empty() == false )
+        return ArgumentCachePtr();
+
+    return res;
+}
+
+void Process::check_types( Action & action )
+{
+    if( typeid( action ) == typeid( SendSignal ) )
+    {
+        auto & a = dynamic_cast< SendSignal &>( action );
+
+        if( a.to )
+            mem_.check_types( * a.to );
+
+        for( auto & e : a.arguments )
+            mem_.check_types( * e );
+    }
+    else if( typeid( action ) == typeid( FunctionCall ) )
+    {
+        for( auto & e : dynamic_cast< FunctionCall &>( action ).arguments )
+            mem_.check_types( * e.second );
+    }
+    else if( typeid( action ) == typeid( SetTimer ) )
+    {
+        mem_.check_types( * dynamic_cast< SetTimer &>( action ).delay );
+    }
+    else if( typeid( action ) == typeid( Task ) )
+    {
+        check_types( dynamic_cast< Task &>( action ) );
+    }
+    else if( typeid( action ) == typeid( Condition ) )
+    {
+        check_types( dynamic_cast< Condition &>( action ) );
+    }
+    else if( typeid( action ) == typeid( SwitchCondition ) )
+    {
+        auto & a = dynamic_cast< SwitchCondition &>( action );
+
+        mem_.check_types( * a.var );
+
+        for( auto & e : a.values )
+            mem_.check_types( * e );
+    }
+}
+
+void Process::check_types( Condition & a )
+{
+    auto lhs_type = mem_.check_types( * a.lhs );
+
+    if( a.type == comparison_type_e::NOT )
+    {
+        if( lhs_type != data_type_e::UNDEF && lhs_type != data_type_e::BOOL )
+        {
+            dummy_logi_fatal( log_id_, id_, "type mismatch: condition NOT on %s", anyvalue::StrHelper::to_string( lhs_type ).c_str() );
+            throw SyntaxError( "type mismatch: condition NOT on " + anyvalue::StrHelper::to_string( lhs_type ) );
+        }
+
+        return;
+    }
+
+    auto rhs_type = mem_.check_types( * a.rhs );
+
+    if( lhs_type == data_type_e::UNDEF || rhs_type == data_type_e::UNDEF )
+        return;
+
+    if( lhs_type != rhs_type && ( Memory::is_numeric( lhs_type ) == false || Memory::is_numeric( rhs_type ) == false ) )
+    {
+        dummy_logi_fatal( log_id_, id_, "type mismatch: condition %s %s %s",
+                anyvalue::StrHelper::to_string( lhs_type ).c_str(), anyvalue::StrHelper::to_string_short( a.type ).c_str(), anyvalue::StrHelper::to_string( rhs_type ).c_str() );
+        throw SyntaxError( "type mismatch: condition " + anyvalue::StrHelper::to_string( lhs_type ) + " " + anyvalue::StrHelper::to_string_short( a.type ) + " " + anyvalue::StrHelper::to_string( rhs_type ) );
+    }
+
+    if( lhs_type == rhs_type )
+    {
+        a.operand_type  = lhs_type;
+        a.comparison    = TypedOperations::find_comparison( a.type, lhs_type );
+    }
+}
+
+void Process::check_types( Task & a )
+{
+    auto expr_type      = mem_.check_types( * a.expr );
+    auto variable_type  = mem_.get_element_type( a.variable_id );
+
+    if( expr_type == data_type_e::UNDEF || variable_type == data_type_e::UNDEF || expr_type == variable_type )
+        return;
+
+    // the value is converted to the type of the variable
+    if( Memory::is_numeric( expr_type ) && Memory::is_numeric( variable_type ) )
+        return;
+
+    dummy_logi_fatal( log_id_, id_, "type mismatch: task %s := %s",
+            anyvalue::StrHelper::to_string( variable_type ).c_str(), anyvalue::StrHelper::to_string( expr_type ).c_str() );
+    throw SyntaxError( "type mismatch: task " + anyvalue::StrHelper::to_string( variable_type ) + " := " + anyvalue::StrHelper::to_string( expr_type ) );
+}
+
+SwitchTablePtr Process::create_switch_table( const std::vector<ExpressionPtr> & values )
+{
+    if( values.empty() )
+        return SwitchTablePtr();
+
+    SwitchTablePtr res( new SwitchTable );
+
+    int i = 0;
+
+    for( auto & e : values )
+    {
+        ++i;
+
+        if( mem_.is_constant_expression( * e ) == false )
+            return SwitchTablePtr();
+
+        Value v;
+
+        mem_.evaluate_expression( & v, e );
+
+        if( i == 1 )
+            res->type = v.type;
+        else if( v.type != res->type )
+            return SwitchTablePtr();    // mixed types are compared with conversion, keep the linear search
+
+        // emplace() keeps the first of duplicate cases, as the linear search does
+        switch( v.type )
+        {
+        case data_type_e::BOOL:
+            res->map_int_to_case.emplace( int64_t( v.arg_b ), i );
+            break;
+        case data_type_e::INT:
+            res->map_int_to_case.emplace( int64_t( v.arg_i ), i );
+            break;
+        case data_type_e::DOUBLE:
+            res->map_double_to_case.emplace( v.arg_d, i );
+            break;
+        case data_type_e::STRING:
+            res->map_string_to_case.emplace( v.arg_s, i );
+            break;
+        default:
+            return SwitchTablePtr();
+        }
+    }
+
+    return res;
+}
+
+int Process::find_switch_case( const SwitchTable & table, const Value & value )
+{
+    switch( table.type )
+    {
+    case data_type_e::BOOL:
+    {
+        auto it = table.map_int_to_case.find( int64_t( value.arg_b ) );
+        return ( it != table.map_int_to_case.end() ) ? it->second : 0;
+    }
+    case data_type_e::INT:
+    {
+        auto it = table.map_int_to_case.find( int64_t( value.arg_i ) );
+        return ( it != table.map_int_to_case.end() ) ? it->second : 0;
+    }
+    case data_type_e::DOUBLE:
+    {
+        auto it = table.map_double_to_case.find( value.arg_d );
+        return ( it != table.map_double_to_case.end() ) ? it->second : 0;
+    }
+    case data_type_e::STRING:
+    {
+        auto it = table.map_string_to_case.find( value.arg_s );
+        return ( it != table.map_string_to_case.end() ) ? it->second : 0;
+    }
+    default:
+        return 0;
+    }
+}
+
+bool Process::handle( const ev::Signal & req )
+{
+    dummy_logi_trace( log_id_, id_, "handle: %s", typeid( req ).name() );
+
+    if( is_ended() == true )
+    {
+        dummy_logi_info( log_id_, id_, "process finished, ignoring" );
+
+        return false;
+    }
+
+    assert( internal_state_ == internal_state_e::ACTIVE );
+
+    auto is_saved = handle_signal( req );
+
+    if( is_saved )
+    {
+        save_signal( & req );
+    }
+
+    handle_saved_signals();
+
+    return is_saved;
+}
+
+void Process::handle_shared( const ev::Signal & req )
+{
+    dummy_logi_trace( log_id_, id_, "handle shared: %s", typeid( req ).name() );
+
+    if( is_ended() == true )
+    {
+        dummy_logi_info( log_id_, id_, "process finished, ignoring" );
+
+        return;
+    }
+
+    assert( internal_state_ == internal_state_e::ACTIVE );
+
+    if( handle_signal( req ) )
+    {
+        save_signal( new ev::Signal( req ) );
+    }
+
+    handle_saved_signals();
+}
+
+void Process::handle( const ev::Timer & req )
+{
+    dummy_logi_trace( log_id_, id_, "handle: %s", typeid( req ).name() );
+
+    if( is_ended() == true )
+    {
+        dummy_logi_info( log_id_, id_, "process finished, ignoring" );
+
+        return;
+    }
+
+    assert( internal_state_ == internal_state_e::ACTIVE );
+
+    if( req.epoch != epoch_ )
+    {
+        // the timer fired before the process was migrated to another definition, the migrated timer is set again
+        dummy_logi_info( log_id_, id_, "timer %u of epoch %u, current epoch %u, ignoring", req.timer_id, req.epoch, epoch_ );
+        return;
+    }
+
+    auto timer = find_timer( req.timer_id );
+
+    if( timer == nullptr )
+    {
+        dummy_logi_info( log_id_, id_, "unknown timer %u, ignoring", req.timer_id );
+        return;
+    }
+
+    auto job_id = timer->get_job_id();
+
+    if( job_id == 0 )
+    {
+        dummy_logi_info( log_id_, id_, "timer %u is already cancelled", req.timer_id );
+        return;
+    }
+
+    timer->set_job_id( 0 ); // cancel scheduler job id
+
+    auto & name = timer->get_name();
+
+    std::vector<Value> dummy;
+
+    ev::Signal signal( id_, name, dummy );
+
+    // the signal of the timer is temporary
+    handle_shared( signal );
+}
+
+void Process::set_parent_process_id( uint32_t parent_process_id )
+{
+    parent_process_id_  = parent_process_id;
+}
+
+uint32_t Process::get_parent_process_id() const
+{
+    return parent_process_id_;
+}
+
+void Process::set_epoch( uint32_t epoch )
+{
+    epoch_  = epoch;
+}
+
+uint32_t Process::get_epoch() const
+{
+    return epoch_;
+}
+
+void Process::set_definition( DefinitionPtr definition )
+{
+    definition_ = definition;
+
+    mem_.set_string_pool( definition_ ? definition_->string_pool.get() : nullptr );
+}
+
+const DefinitionPtr & Process::get_definition() const
+{
+    return definition_;
+}
+
+void Process::set_profile( ExecutionProfile * profile )
+{
+    profile_    = profile;
+}
+
+void Process::reset_timers()
+{
+    for( auto & e : map_id_to_timer_ )
+    {
+        reset_timer( e.second.get() );
+    }
+}
+
+void Process::reset( uint32_t id )
+{
+    assert( is_ended() );
+
+    reset_timers();
+
+    dummy_logi_info( log_id_, id_, "reset, new id %u", id );
+
+    id_ = id;
+
+    names_.set_id( id );
+
+    mem_.reset( id );
+
+    for( auto & e : map_id_to_state_ )
+    {
+        e.second->set_process_id( id );
+    }
+
+    internal_state_             = internal_state_e::IDLE;
+    current_state_              = initial_state_;
+    matched_switch_condition_   = 0;
+    parent_process_id_          = 0;
+
+    clear_saved_signals();
+
+    error_.clear();
+}
+
+void Process::save( std::ostream & os ) const
+{
+    Serializer::save( os, SNAPSHOT_VERSION );
+    Serializer::save( os, parent_process_id_ );
+
+    save_header( os );
+
+    mem_.save( os );
+
+    save_timers( os );
+
+    save_saved_signals( os );
+}
+
+bool Process::load( std::istream & is, std::string * error_msg )
+{
+    return load( is, NameMapper(), error_msg );
+}
+
+bool Process::load( std::istream & is, const NameMapper & mapper, std::string * error_msg )
+{
+    dummy_logi_trace( log_id_, id_, "load" );
+
+    assert( internal_state_ == internal_state_e::IDLE );
+
+    uint32_t version;
+
+    if( Serializer::load( & version, is ) == false )
+    {
+        * error_msg = "cannot read snapshot version";
+        return false;
+    }
+
+    if( version != SNAPSHOT_VERSION )
+    {
+        * error_msg = "unsupported snapshot version " + std::to_string( version );
+        return false;
+    }
+
+    uint32_t parent_process_id;
+
+    if( Serializer::load( & parent_process_id, is ) == false )
+    {
+        * error_msg = "cannot read parent process id";
+        return false;
+    }
+
+    if( load_runtime_state( is, mapper, error_msg ) == false )
+        return false;
+
+    parent_process_id_  = parent_process_id;
+
+    return true;
+}
+
+void Process::save_delta( std::ostream & os )
+{
+    save_header( os );
+
+    mem_.save_changed( os );
+
+    save_timers( os );
+
+    save_saved_signals( os );
+}
+
+bool Process::load_delta( std::istream & is, std::string * error_msg )
+{
+    dummy_logi_trace( log_id_, id_, "load_delta" );
+
+    return load_runtime_state( is, NameMapper(), error_msg );
+}
+
+void Process::save_header( std::ostream & os ) const
+{
+    Serializer::save( os, uint8_t( internal_state_ ) );
+    Serializer::save( os, names_.get_name( current_state_ ) );
+}
+
+void Process::save_timers( std::ostream & os ) const
+{
+    auto now_sys    = std::chrono::system_clock::now();
+    auto now        = std::chrono::steady_clock::now();
+
+    uint32_t num_active_timers = 0;
+
+    for( auto & e : map_id_to_timer_ )
+    {
+        if( e.second->get_job_id() != 0 )
+            ++num_active_timers;
+    }
+
+    Serializer::save( os, num_active_timers );
+
+    for( auto & e : map_id_to_timer_ )
+    {
+        auto & timer = * e.second;
+
+        if( timer.get_job_id() == 0 )
+            continue;
+
+        // wall-clock fire time, so that the remaining time is rebased automatically on restore
+        auto fire_time_sys = now_sys + std::chrono::duration_cast<std::chrono::system_clock::duration>( timer.get_fire_time() - now );
+
+        Serializer::save( os, timer.get_name() );
+        Serializer::save( os, uint64_t( std::chrono::duration_cast<std::chrono::milliseconds>( fire_time_sys.time_since_epoch() ).count() ) );
+    }
+}
+
+void Process::save_saved_signals( std::ostream & os ) const
+{
+    uint32_t num_saved_signals = 0;
+
+    for( auto e = saved_signals_head_; e != nullptr; e = e->next_saved )
+        ++num_saved_signals;
+
+    Serializer::save( os, num_saved_signals );
+
+    for( auto e = saved_signals_head_; e != nullptr; e = e->next_saved )
+    {
+        Serializer::save( os, e->name );
+        Serializer::save( os, uint32_t( e->arguments.size() ) );
+
+        for( auto & a : e->arguments )
+        {
+            Serializer::save( os, a );
+        }
+    }
+}
+
+bool Process::load_saved_signals( std::istream & is, std::string * error_msg )
+{
+    uint32_t num_saved_signals;
+
+    if( Serializer::load( & num_saved_signals, is ) == false )
+    {
+        * error_msg = "cannot read number of saved signals";
+        return false;
+    }
+
+    clear_saved_signals();
+
+    for( uint32_t i = 0; i < num_saved_signals; ++i )
+    {
+        std::string name;
+        uint32_t    size;
+
+        if( Serializer::load( & name, is ) == false || Serializer::load( & size, is ) == false )
+        {
+            * error_msg = "cannot read saved signal";
+            return false;
+        }
 
-    auto b = map_id_to_action_connector_.insert( std::make_pair( id, obj ) ).second;
+        if( size > Serializer::MAX_NUM_ARGUMENTS )
+        {
+            * error_msg = "saved signal " + name + ": invalid number of arguments " + std::to_string( size );
+            return false;
+        }
 
-    assert( b );
+        std::vector<Value> arguments( size );
 
-    dummy_logi_debug( log_id_, id_, "create_action_connector: created action connector %u", id );
+        for( auto & a : arguments )
+        {
+            if( Serializer::load( & a, is ) == false )
+            {
+                * error_msg = "cannot read argument of saved signal " + name;
+                return false;
+            }
+        }
 
-    return id;
-}
+        save_signal( new ev::Signal( id_, name, std::move( arguments ) ) );
+    }
 
-element_id_t Process::create_add_variable( const std::string & name, data_type_e type )
-{
-    return mem_.create_add_variable( name, type );
+    return true;
 }
 
-element_id_t Process::create_add_variable( const std::string & name, data_type_e type, const Value & value )
+bool Process::load_runtime_state( std::istream & is, const NameMapper & mapper, std::string * error_msg )
 {
-    return mem_.create_add_variable( name, type, value );
-}
+    uint8_t     internal_state;
+    std::string state_name;
 
-element_id_t Process::create_add_constant( const std::string & name, data_type_e type, const Value & value )
-{
-    return mem_.create_add_constant( name, type, value );
-}
+    if( Serializer::load( & internal_state, is ) == false
+            || Serializer::load( & state_name, is ) == false )
+    {
+        * error_msg = "cannot read process header";
+        return false;
+    }
 
-void Process::set_initial_state( element_id_t state_id )
-{
-    dummy_logi_trace( log_id_, id_, "set_initial_state: %u", state_id );
+    if( internal_state > uint8_t( internal_state_e::FINISHED ) )
+    {
+        * error_msg = "invalid internal state " + std::to_string( internal_state );
+        return false;
+    }
 
-    assert( current_state_ == 0 );
+    if( mapper )
+        state_name = mapper( state_name );
+
+    auto state_id = names_.find_element( state_name );
+
+    if( find_state( state_id ) == nullptr )
+    {
+        * error_msg = "unknown state " + state_name;
+        return false;
+    }
+
+    if( mem_.load( is, mapper, error_msg ) == false )
+        return false;
 
+    internal_state_ = internal_state_e( internal_state );
     current_state_  = state_id;
-}
 
-void Process::handle( const ev::Signal & req )
-{
-    dummy_logi_trace( log_id_, id_, "handle: %s", typeid( req ).name() );
+    uint32_t num_active_timers;
 
-    if( is_ended() == true )
+    if( Serializer::load( & num_active_timers, is ) == false )
     {
-        dummy_logi_info( log_id_, id_, "process finished, ignoring" );
-
-        return;
+        * error_msg = "cannot read number of timers";
+        return false;
     }
 
-    assert( internal_state_ == internal_state_e::ACTIVE );
+    reset_timers();
 
-    auto state = find_state( current_state_ );
+    auto now_sys = uint64_t( std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::system_clock::now().time_since_epoch() ).count() );
 
-    assert( state != nullptr );
+    for( uint32_t i = 0; i < num_active_timers; ++i )
+    {
+        std::string name;
+        uint64_t    fire_time;
 
-    std::vector<element_id_t> arguments;
+        if( Serializer::load( & name, is ) == false || Serializer::load( & fire_time, is ) == false )
+        {
+            * error_msg = "cannot read timer";
+            return false;
+        }
 
-    mem_.init_temp_variables_from_signal( req, & arguments );
+        if( mapper )
+            name = mapper( name );
 
-    state->handle_signal( req.name, arguments );
-}
+        auto timer = name.empty() ? nullptr : find_timer( names_.find_element( name ) );
 
-void Process::handle( const ev::Timer & req )
-{
-    dummy_logi_trace( log_id_, id_, "handle: %s", typeid( req ).name() );
+        if( timer == nullptr )
+        {
+            dummy_logi_warn( log_id_, id_, "load: unknown timer %s, ignored", name.c_str() );
+            continue;
+        }
 
-    if( is_ended() == true )
-    {
-        dummy_logi_info( log_id_, id_, "process finished, ignoring" );
+        if( internal_state_ != internal_state_e::ACTIVE )
+            continue;
 
-        return;
+        Value delay;
+
+        delay.type  = data_type_e::DOUBLE;
+        delay.arg_d = ( fire_time > now_sys ) ? double( fire_time - now_sys ) / 1000 : 0;
+
+        harmonize( & delay );
+
+        set_timer( timer, delay );
     }
 
-    assert( internal_state_ == internal_state_e::ACTIVE );
+    if( load_saved_signals( is, error_msg ) == false )
+        return false;
 
-    auto timer = find_timer( req.timer_id );
+    dummy_logi_debug( log_id_, id_, "load: state %s, %u active timers", state_name.c_str(), num_active_timers );
 
-    assert( timer != nullptr );
+    return true;
+}
 
-    auto job_id = timer->get_job_id();
+std::size_t Process::get_memory_usage() const
+{
+    std::size_t res = sizeof( * this ) + names_.get_memory_usage() + mem_.get_memory_usage();
 
-    if( job_id == 0 )
+    for( auto & e : map_id_to_state_ )
     {
-        dummy_logi_info( log_id_, id_, "timer %u is already cancelled", req.timer_id );
-        return;
+        res += SizeHelper::MAP_NODE_OVERHEAD + sizeof( e ) + e.second->get_memory_usage();
     }
 
-    timer->set_job_id( 0 ); // cancel scheduler job id
+    for( auto & e : map_id_to_signal_handler_ )
+    {
+        res += SizeHelper::MAP_NODE_OVERHEAD + sizeof( e ) + e.second->get_memory_usage();
+    }
 
-    auto & name = timer->get_name();
+    for( auto & e : map_id_to_action_connector_ )
+    {
+        res += SizeHelper::MAP_NODE_OVERHEAD + sizeof( e ) + e.second->get_memory_usage();
+    }
 
-    std::vector<Value> dummy;
+    for( auto & e : map_id_to_timer_ )
+    {
+        res += SizeHelper::MAP_NODE_OVERHEAD + sizeof( e ) + e.second->get_memory_usage();
+    }
 
-    ev::Signal signal( id_, name, dummy );
+    for( auto & e : coalesced_signals_ )
+    {
+        res += SizeHelper::MAP_NODE_OVERHEAD + sizeof( e ) + SizeHelper::get_size( e );
+    }
 
-    handle( signal );
+    for( auto e = saved_signals_head_; e != nullptr; e = e->next_saved )
+    {
+        res += sizeof( * e ) + SizeHelper::get_size( e->name ) + e->arguments.capacity() * sizeof( Value );
+    }
+
+    return res;
 }
 
 State* Process::find_state( element_id_t id )
@@ -430,7 +1447,7 @@ State* Process::find_state( element_id_t id )
 
         if( it != map_id_to_state_.end() )
         {
-            return it->second;
+            return it->second.get();
         }
     }
 
@@ -444,7 +1461,7 @@ Timer* Process::find_timer( element_id_t id )
 
         if( it != map_id_to_timer_.end() )
         {
-            return it->second;
+            return it->second.get();
         }
     }
 
@@ -457,7 +1474,7 @@ ActionConnector* Process::find_action_connector( element_id_t id )
 
     if( it != map_id_to_action_connector_.end() )
     {
-        return it->second;
+        return it->second.get();
     }
 
     return nullptr;
@@ -469,7 +1486,7 @@ const ActionConnector* Process::find_action_connector( element_id_t id ) const
 
     if( it != map_id_to_action_connector_.end() )
     {
-        return it->second;
+        return it->second.get();
     }
 
     return nullptr;
@@ -485,42 +1502,41 @@ void Process::set_timer( Timer * timer, const Value & delay )
     if( job_id != 0 )
     {
         dummy_logi_fatal( log_id_, id_, "timer id %u is active (job id %u)", timer_id, job_id );
-        assert( 0 );
-        throw SyntaxError( "timer " + std::to_string( timer_id ) + " is active (job id " + std::to_string( job_id ) + ")" );
+        raise_error( "timer " + std::to_string( timer_id ) + " is active (job id " + std::to_string( job_id ) + ")" );
         return;
     }
 
     auto & name = timer->get_name();
 
-    std::vector<Value> dummy;
-
-    auto signal = new ev::Timer( id_, timer_id );
-
     std::string error_msg;
 
     scheduler::job_id_t sched_job_id;
 
+    auto parent     = parent_;
+    auto process_id = id_;
+    auto epoch      = epoch_;
+
     auto b = scheduler::create_and_insert_timeout_job(
             & sched_job_id,
             & error_msg,
             * scheduler_,
             "timer_job",
             scheduler::Duration( delay.arg_d ),
-            std::bind( static_cast<void (IFsm::*)(const ev::Object * )>(&IFsm::consume), parent_, signal ) );
+            // the event is created when the job fires, i.e. a cancelled job leaves nothing behind
+            [parent, process_id, timer_id, epoch]() { parent->consume( new ev::Timer( process_id, timer_id, epoch ) ); } );
 
     if( b == false )
     {
         dummy_logi_error( log_id_, id_, "cannot set timer: %s", error_msg.c_str() );
 
         timer->set_job_id( 0 );
-
-        delete signal;
     }
     else
     {
-        dummy_logi_debug( log_id_, id_, "timer %s, process %u, scheduled execution in: %.2f sec", name.c_str(), signal->process_id, delay.arg_d );
+        dummy_logi_debug( log_id_, id_, "timer %s, process %u, scheduled execution in: %.2f sec", name.c_str(), id_, delay.arg_d );
 
         timer->set_job_id( sched_job_id );
+        timer->set_fire_time( std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>( std::chrono::duration<double>( delay.arg_d ) ) );
     }
 
 }
@@ -592,44 +1608,64 @@ void Process::execute_action_connector_id( element_id_t action_connector_id )
 {
     dummy_logi_trace( log_id_, id_, "execute_action_connector_id: action_connector_id %u", action_connector_id );
 
-    auto action_connector = find_action_connector( action_connector_id );
+    // all references are validated by finalize()
+    auto it = map_id_to_action_connector_.find( action_connector_id );
 
-    if( action_connector == nullptr )
-    {
-        dummy_logi_fatal( log_id_, id_, "cannot find action connector %u", action_connector_id );
-        assert( 0 );
-        throw SyntaxError( "cannot find action connector " + std::to_string( action_connector_id ) );
-    }
+    assert( it != map_id_to_action_connector_.end() );
 
-    execute_action_connector( * action_connector );
+    execute_action_connector( * it->second );
 }
 
 void Process::execute_action_connector( const ActionConnector & action_connector )
 {
+    FlightRecorder::record( FlightRecorder::event_type_e::ACTION_CONNECTOR, id_, current_state_, 0, action_connector.get_id() );
+
     auto & action = * action_connector.get_action();
 
+    auto begin = profile_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
     auto flow_control = handle_action( action );
 
+    if( profile_ )
+    {
+        profile_->add_action_connector( action_connector.get_id(), std::chrono::steady_clock::now() - begin );
+    }
+
+    // the failed action ends the process
+    if( is_exception_free_ && has_error() )
+    {
+        terminate( get_error() );
+        return;
+    }
+
+    element_id_t next_id;
+
     if( flow_control == flow_control_e::NEXT )
     {
-        execute_action_connector_id( action_connector.get_next_id() );
+        next_id = action_connector.get_next_id();
     }
     else if( flow_control == flow_control_e::ALT_NEXT )
     {
-        execute_action_connector_id( action_connector.get_alt_next_id() );
+        next_id = action_connector.get_alt_next_id();
     }
     else if( flow_control == flow_control_e::CHECK_SWITCH )
     {
         auto matched_switch_condition = get_matched_switch_condition_and_clear();
 
-        auto id = action_connector.get_switch_action( matched_switch_condition );
-
-        execute_action_connector_id( id );
+        next_id = action_connector.get_switch_action( matched_switch_condition );
     }
     else // if( flow_control == flow_control_e::STOP )
     {
         // do nothing, just exit
+        return;
+    }
+
+    if( profile_ )
+    {
+        profile_->add_edge( action_connector.get_id(), next_id );
     }
+
+    execute_action_connector_id( next_id );
 }
 
 Process::flow_control_e Process::handle_action( const Action & action )
@@ -673,11 +1709,78 @@ Process::flow_control_e Process::handle_SendSignal( const Action & aa )
 {
     auto & a = dynamic_cast< const SendSignal &>( aa );
 
+    if( a.cache )
+    {
+        // the cached list is passed as is, its variable slots are overwritten by the next execution
+        auto & values = a.cache->values;
+
+        for( auto i : a.cache->variable_slots )
+        {
+            Value v;
+
+            mem_.evaluate_expression( & v, a.arguments[i] );
+
+            values[i] = std::move( v );
+        }
+
+        if( mem_.has_error() )
+            return flow_control_e::STOP;
+
+        callback_->handle_send_signal( id_, a.name, values );
+
+        return flow_control_e::NEXT;
+    }
+
     std::vector<Value> values;
 
     mem_.evaluate_expressions( & values, a.arguments );
 
-    callback_->handle_send_signal( id_, a.name, values );
+    // exception-free mode, the value is undefined
+    if( mem_.has_error() )
+        return flow_control_e::STOP;
+
+    if( a.target == SendSignal::target_e::ENV )
+    {
+        callback_->handle_send_signal( id_, a.name, values );
+
+        return flow_control_e::NEXT;
+    }
+
+    uint32_t process_id = id_;
+
+    if( a.target == SendSignal::target_e::PARENT )
+    {
+        process_id  = parent_process_id_;
+
+        if( process_id == 0 )
+        {
+            dummy_logi_error( log_id_, id_, "signal %s: process has no parent", a.name.c_str() );
+            raise_error( "signal " + a.name + ": process has no parent" );
+            return flow_control_e::STOP;
+        }
+    }
+    else if( a.target == SendSignal::target_e::PROCESS )
+    {
+        Value to;
+
+        mem_.evaluate_expression( & to, a.to );
+
+        if( mem_.has_error() )
+            return flow_control_e::STOP;
+
+        if( to.type != data_type_e::INT || to.arg_i <= 0 || to.arg_i > int64_t( UINT32_MAX ) )
+        {
+            dummy_logi_error( log_id_, id_, "signal %s: invalid process id", a.name.c_str() );
+            raise_error( "signal " + a.name + ": invalid process id" );
+            return flow_control_e::STOP;
+        }
+
+        process_id  = uint32_t( to.arg_i );
+    }
+
+    dummy_logi_debug( log_id_, id_, "send signal %s to process %u", a.name.c_str(), process_id );
+
+    parent_->send_signal( process_id, a.name, std::move( values ) );
 
     return flow_control_e::NEXT;
 }
@@ -686,20 +1789,18 @@ Process::flow_control_e Process::handle_SetTimer( const Action & aa )
 {
     auto & a = dynamic_cast< const SetTimer &>( aa );
 
-    auto timer = find_timer( a.timer_id );
-
-    if( timer == nullptr )
-    {
-        dummy_logi_fatal( log_id_, id_, "cannot find timer %u", a.timer_id );
-        assert( 0 );
-        throw SyntaxError( "cannot find timer " + std::to_string( a.timer_id ) );
-    }
+    // resolved by finalize()
+    assert( a.timer );
 
     Value delay;
 
     mem_.evaluate_expression( & delay, a.delay );
 
-    set_timer( timer, delay );
+    // exception-free mode, the value is undefined
+    if( mem_.has_error() )
+        return flow_control_e::STOP;
+
+    set_timer( a.timer, delay );
 
     return flow_control_e::NEXT;
 }
@@ -708,16 +1809,10 @@ Process::flow_control_e Process::handle_ResetTimer( const Action & aa )
 {
     auto & a = dynamic_cast< const ResetTimer &>( aa );
 
-    auto timer = find_timer( a.timer_id );
-
-    if( timer == nullptr )
-    {
-        dummy_logi_fatal( log_id_, id_, "cannot find timer %u", a.timer_id );
-        assert( 0 );
-        throw SyntaxError( "cannot find timer " + std::to_string( a.timer_id ) );
-    }
+    // resolved by finalize()
+    assert( a.timer );
 
-    reset_timer( timer );
+    reset_timer( a.timer );
 
     return flow_control_e::NEXT;
 }
@@ -728,7 +1823,24 @@ Process::flow_control_e Process::handle_FunctionCall( const Action & aa )
 
     std::vector<Value> values;
 
-    mem_.evaluate_expressions( & values, a.arguments );
+    if( a.cache )
+    {
+        // the callee may modify any argument, so it gets a copy
+        values = a.cache->values;
+
+        for( auto i : a.cache->variable_slots )
+        {
+            mem_.evaluate_expression( & values[i], a.arguments[i].second );
+        }
+    }
+    else
+    {
+        mem_.evaluate_expressions( & values, a.arguments );
+    }
+
+    // exception-free mode, the value is undefined
+    if( mem_.has_error() )
+        return flow_control_e::STOP;
 
     std::vector<Value*> value_pointers;
 
@@ -747,19 +1859,34 @@ Process::flow_control_e Process::handle_Task( const Action & aa )
 {
     auto & a = dynamic_cast< const Task &>( aa );
 
-    auto variable = mem_.find_variable( a.variable_id );
+    // resolved by finalize()
+    auto variable = a.variable;
 
-    if( variable == nullptr )
+    assert( variable );
+
+    auto source = mem_.find_compact_value( * a.expr );
+
+    if( source )
     {
-        dummy_logi_fatal( log_id_, id_, "cannot find variable %u", a.variable_id );
-        assert( 0 );
-        throw SyntaxError( "cannot find variable " + std::to_string( a.variable_id ) );
+        // a literal, a variable or a constant, a long string is shared, not copied
+        variable->assign( * source );
+
+        dummy_logi_debug( log_id_, id_, "task: %s (%i) = %s value",
+                variable->get_name().c_str(),
+                variable->get_id(),
+                anyvalue::StrHelper::to_string( source->get_type() ).c_str() );
+
+        return flow_control_e::NEXT;
     }
 
     Value res;
 
     mem_.evaluate_expression( & res, a.expr );
 
+    // exception-free mode, the value is undefined
+    if( mem_.has_error() )
+        return flow_control_e::STOP;
+
     variable->assign( res );
 
     dummy_logi_debug( log_id_, id_, "task: %s (%i) = %s",
@@ -782,6 +1909,9 @@ Process::flow_control_e Process::handle_Condition( const Action & aa )
 
         mem_.evaluate_expression( & val, a.lhs );
 
+        if( mem_.has_error() )
+            return flow_control_e::STOP;
+
         auto b = ! val.arg_b;
 
         dummy_logi_debug( log_id_, id_, "condition ( %s %s ) evaluated to %s",
@@ -792,13 +1922,40 @@ Process::flow_control_e Process::handle_Condition( const Action & aa )
         return b ? flow_control_e::NEXT : flow_control_e::ALT_NEXT;
     }
 
+    if( a.operand_type == data_type_e::STRING && ( a.type == comparison_type_e::EQ || a.type == comparison_type_e::NEQ ) )
+    {
+        // interned strings are equal if they share the buffer, no need to copy and compare them
+        auto lhs = mem_.find_compact_value( * a.lhs );
+        auto rhs = mem_.find_compact_value( * a.rhs );
+
+        if( lhs && rhs && lhs->is_same_buffer( * rhs ) )
+        {
+            auto b = a.type == comparison_type_e::EQ;
+
+            dummy_logi_debug( log_id_, id_, "condition ( %s ) on the same interned string evaluated to %s",
+                    anyvalue::StrHelper::to_string_short( a.type ).c_str(),
+                    b ? "TRUE" : "FALSE" );
+
+            return b ? flow_control_e::NEXT : flow_control_e::ALT_NEXT;
+        }
+    }
+
     Value lhs;
     mem_.evaluate_expression( & lhs, a.lhs );
 
     Value rhs;
     mem_.evaluate_expression( & rhs, a.rhs );
 
-    auto b = anyvalue::compare_values( a.type, lhs, rhs );
+    // exception-free mode, the value is undefined
+    if( mem_.has_error() )
+        return flow_control_e::STOP;
+
+    bool b;
+
+    if( a.comparison )
+        b = a.comparison( lhs, rhs );
+    else
+        b = anyvalue::compare_values( a.type, lhs, rhs );
 
     dummy_logi_debug( log_id_, id_, "condition ( %s %s %s ) evaluated to %s",
             anyvalue::StrHelper::to_string( lhs ).c_str(),
@@ -817,6 +1974,22 @@ Process::flow_control_e Process::handle_SwitchCondition( const Action & aa )
 
     mem_.evaluate_expression( & lhs, a.var );
 
+    // exception-free mode, the value is undefined
+    if( mem_.has_error() )
+        return flow_control_e::STOP;
+
+    if( a.table && lhs.type == a.table->type )
+    {
+        auto i = find_switch_case( * a.table, lhs );
+
+        dummy_logi_debug( log_id_, id_, "switch variable %s, executing case %d (0 - default)",
+                anyvalue::StrHelper::to_string( lhs ).c_str(), i );
+
+        set_matched_switch_condition( i ? i : -1 );
+
+        return flow_control_e::CHECK_SWITCH;
+    }
+
     int i = 0;
 
     for( auto & e : a.values )
@@ -827,6 +2000,9 @@ Process::flow_control_e Process::handle_SwitchCondition( const Action & aa )
 
         mem_.evaluate_expression( & rhs, e );
 
+        if( mem_.has_error() )
+            return flow_control_e::STOP;
+
         auto b = anyvalue::compare_values( comparison_type_e::EQ, lhs, rhs );
 
         if( b == true )
@@ -854,15 +2030,7 @@ Process::flow_control_e Process::handle_NextState( const Action & aa )
 {
     auto & a = dynamic_cast< const NextState &>( aa );
 
-    auto state = find_state( a.state_id );
-
-    if( state == nullptr )
-    {
-        dummy_logi_fatal( log_id_, id_, "cannot find state %u", a.state_id );
-        assert( 0 );
-        throw SyntaxError( "cannot find state " + std::to_string( a.state_id ) );
-    }
-
+    // the state is validated by finalize()
     next_state( a.state_id );
 
     return flow_control_e::STOP;
@@ -887,7 +2055,117 @@ void Process::next_state( element_id_t state )
         dummy_logi_debug( log_id_, id_, "switched state %s (%u) --> %s (%u)", names_.get_name( current_state_ ).c_str(), current_state_, names_.get_name( state ).c_str(), state );
     }
 
+    if( state != current_state_ )
+    {
+        is_state_changed_   = true;
+    }
+
     current_state_  = state;
+
+    FlightRecorder::record( FlightRecorder::event_type_e::NEXT_STATE, id_, current_state_, 0, 0 );
+}
+
+bool Process::handle_signal( const ev::Signal & req )
+{
+    auto state = find_state( current_state_ );
+
+    assert( state != nullptr );
+
+    if( state->is_saved( req.name ) )
+    {
+        dummy_logi_debug( log_id_, id_, "signal %s saved in state %s (%u)", req.name.c_str(), state->get_name().c_str(), current_state_ );
+        return true;
+    }
+
+    std::vector<element_id_t> arguments;
+
+    mem_.init_temp_variables_from_signal( req, & arguments );
+
+    state->handle_signal( req.name, arguments );
+
+    return false;
+}
+
+void Process::save_signal( const ev::Signal * req )
+{
+    req->next_saved = nullptr;
+
+    if( saved_signals_tail_ )
+        saved_signals_tail_->next_saved = req;
+    else
+        saved_signals_head_ = req;
+
+    saved_signals_tail_ = req;
+}
+
+void Process::handle_saved_signals()
+{
+    while( is_state_changed_ )
+    {
+        is_state_changed_   = false;
+
+        const ev::Signal * prev = nullptr;
+        auto signal             = saved_signals_head_;
+
+        // a state change restarts from the head, SDL handles the oldest signal first
+        while( signal != nullptr && is_state_changed_ == false && is_ended() == false )
+        {
+            auto state = find_state( current_state_ );
+
+            assert( state != nullptr );
+
+            if( state->is_saved( signal->name ) )
+            {
+                prev    = signal;
+                signal  = signal->next_saved;
+                continue;
+            }
+
+            auto next = signal->next_saved;
+
+            if( prev )
+                prev->next_saved = next;
+            else
+                saved_signals_head_ = next;
+
+            if( saved_signals_tail_ == signal )
+                saved_signals_tail_ = prev;
+
+            std::unique_ptr<const ev::Signal> req( signal );
+
+            signal  = next;
+
+            if( state->has_signal_handler( req->name ) == false )
+            {
+                dummy_logi_info( log_id_, id_, "saved signal %s discarded in state %s (%u)", req->name.c_str(), state->get_name().c_str(), current_state_ );
+                continue;
+            }
+
+            dummy_logi_debug( log_id_, id_, "handle saved signal %s", req->name.c_str() );
+
+            handle_signal( * req );
+        }
+    }
+
+    if( is_ended() )
+    {
+        clear_saved_signals();
+    }
+}
+
+void Process::clear_saved_signals()
+{
+    while( saved_signals_head_ )
+    {
+        auto next = saved_signals_head_->next_saved;
+
+        delete saved_signals_head_;
+
+        saved_signals_head_ = next;
+    }
+
+    saved_signals_tail_ = nullptr;
+    is_state_changed_   = false;
 }
 
 element_id_t Process::get_next_id()
@@ -19,12 +19,16 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-// $Revision: 10395 $ $Date:: 2019-01-05 #$ $Author: serge $
+// $Revision: 11668 $ $Date:: 2019-06-21 #$ $Author: serge $
 
 #ifndef LIB_FSM__PROCESS_H
 #define LIB_FSM__PROCESS_H
 
 #include <map>                  // std::map
+#include <set>                  // std::set
+#include <ostream>              // std::ostream
+#include <istream>              // std::istream
+#include <memory>               // std::unique_ptr
 
 #include "workt/worker_t.h"         // WorkerT
 #include "utils/request_id_gen.h"   // utils::RequestIdGen
@@ -44,6 +48,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include "names_db.h"           // NamesDb
 #include "memory.h"             // Memory
 #include "objects.h"            // ev::Timer
+#include "definition.h"         // DefinitionPtr
 
 namespace fsm {
 
@@ -51,6 +56,8 @@ class Process:
         public ISignalHandler
 {
     friend class SdlGrHelper;
+    friend class CppGenHelper;
+    friend class FlightRecorder;
 
 public:
     Process(
@@ -62,7 +69,10 @@ public:
     ~Process();
 
     void start();
-    void handle( const ev::Signal & req );
+    // returns true if the signal is saved in the current state, the process deletes it once it is handled or discarded
+    bool handle( const ev::Signal & req );
+    // the same, the signal is shared with other processes, e.g. a broadcast, it is copied if it is saved
+    void handle_shared( const ev::Signal & req );
     void handle( const ev::Timer & req );
 
     void handle_signal_handler( element_id_t signal_handler_id, const std::vector<element_id_t> & arguments ) override;
@@ -76,6 +86,8 @@ public:
     element_id_t create_add_start_action_connector( Action * action );
     element_id_t create_state( const std::string & name );
     element_id_t create_add_signal_handler( element_id_t state_id, const std::string & signal_name );
+    // SDL SAVE, saved signals are handled in order once the process enters a state handling them
+    void add_saved_signal( element_id_t state_id, const std::string & signal_name );
     element_id_t create_set_first_action_connector( element_id_t signal_handler_id, Action * action );
     element_id_t create_set_next_action_connector( element_id_t action_connector_id, Action * action );
     element_id_t create_set_alt_next_action_connector( element_id_t action_connector_id, Action * action );
@@ -92,15 +104,59 @@ public:
 
     void set_initial_state( element_id_t state_id );
 
+    // queued signals of the name are merged by FsmManager, only the latest one is handled,
+    // must be called before signals are sent to the process
+    void add_coalesced_signal( const std::string & signal_name );
+    const std::set<std::string> & get_coalesced_signals() const;
+
+    // is called once the definition is complete, removes elements not reachable from the start action connector,
+    // validates references between elements and precomputes constant parts of the definition, throws SyntaxError
+    void finalize();
+
     bool is_ended() const;
 
+    // runtime errors end the process instead of throwing SyntaxError, see has_error()
+    void set_exception_free( bool is_exception_free );
+    bool has_error() const;
+    const std::string & get_error() const;
+    // ends the process with the error, e.g. on an exception caught by FsmManager
+    void terminate( const std::string & error );
+
+    // target of SendSignal TO PARENT, 0 - none
+    void set_parent_process_id( uint32_t parent_process_id );
+    uint32_t get_parent_process_id() const;
+
+    // is carried by the timer events, so that the ones of a replaced instance of the process are ignored, must be set before the timers
+    void set_epoch( uint32_t epoch );
+    uint32_t get_epoch() const;
+
+    void set_definition( DefinitionPtr definition );
+    const DefinitionPtr & get_definition() const;
+
+    // optional, counts executed signal handlers, action connectors and edges, nullptr - disabled
+    void set_profile( ExecutionProfile * profile );
+
+    void reset_timers();
+
+    // prepares an ended process for reuse under another id
+    void reset( uint32_t id );
+
+    void save( std::ostream & os ) const;
+    bool load( std::istream & is, std::string * error_msg );
+    bool load( std::istream & is, const NameMapper & mapper, std::string * error_msg );
+
+    // runtime state with only the variables changed since the previous call, for the journal
+    void save_delta( std::ostream & os );
+    bool load_delta( std::istream & is, std::string * error_msg );
+
+    // approximate number of bytes used by the process and its elements
+    std::size_t get_memory_usage() const;
+
 private:
-    typedef std::map<element_id_t,State*>           MapIdToState;
-    typedef std::map<element_id_t,SignalHandler*>   MapIdToSignalHandler;
-    typedef std::map<element_id_t,ActionConnector*> MapIdToActionConnector;
-    typedef std::map<element_id_t,Variable*>        MapIdToVariable;
-    typedef std::map<element_id_t,Constant*>        MapIdToConstant;
-    typedef std::map<element_id_t,Timer*>           MapIdToTimer;
+    typedef std::map<element_id_t,std::unique_ptr<State>>           MapIdToState;
+    typedef std::map<element_id_t,std::unique_ptr<SignalHandler>>   MapIdToSignalHandler;
+    typedef std::map<element_id_t,std::unique_ptr<ActionConnector>> MapIdToActionConnector;
+    typedef std::map<element_id_t,std::unique_ptr<Timer>>           MapIdToTimer;
 
     enum class flow_control_e
     {
@@ -135,6 +191,9 @@ private:
     const ActionConnector* find_action_connector( element_id_t id ) const;
 
     void set_timer( Timer * timer, const Value & delay );
+
+    // throws SyntaxError or keeps the error in the exception-free mode
+    void raise_error( const std::string & error );
     void reset_timer( Timer * timer );
 
     static void convert_values_to_value_pointers( std::vector<Value*> * value_pointers, std::vector<Value> & values );
@@ -161,31 +220,82 @@ private:
 
     void next_state( element_id_t state );
 
+    // returns true if the signal is to be saved
+    bool handle_signal( const ev::Signal & req );
+    void save_signal( const ev::Signal * req );
+    // handles saved signals after a state change, discards those neither handled nor saved in the new state
+    void handle_saved_signals();
+    void clear_saved_signals();
+
+    void validate();
+    void validate( ActionConnector & action_connector );
+    void validate_next( const ActionConnector & action_connector, element_id_t next_id, const char * kind );
+    void throw_validation_error( const std::string & error ) const;
+
+    unsigned prune_unreachable_elements();
+    void add_successors( std::vector<element_id_t> * ids, element_id_t id ) const;
+    template<class MAP>
+    unsigned prune( MAP * map, const std::set<element_id_t> & reachable, const char * kind );
+
+    ArgumentCachePtr create_argument_cache( const std::vector<ExpressionPtr> & arguments );
+    ArgumentCachePtr create_argument_cache( const std::vector<std::pair<bool,ExpressionPtr>> & arguments );
+    SwitchTablePtr create_switch_table( const std::vector<ExpressionPtr> & values );
+    void check_types( Action & action );
+    void check_types( Condition & action );
+    void check_types( Task & action );
+    static int find_switch_case( const SwitchTable & table, const Value & value );
+
+    void save_header( std::ostream & os ) const;
+    void save_timers( std::ostream & os ) const;
+    // signals deferred by SAVE, so that they survive a snapshot, the journal and a migration
+    void save_saved_signals( std::ostream & os ) const;
+    bool load_saved_signals( std::istream & is, std::string * error_msg );
+    bool load_runtime_state( std::istream & is, const NameMapper & mapper, std::string * error_msg );
+
     element_id_t get_next_id();
 
 private:
 
     uint32_t                    id_;
     uint32_t                    log_id_;
+    uint32_t                    parent_process_id_;
+    uint32_t                    epoch_;
     IFsm                        * parent_;
     ICallback                   * callback_;
     scheduler::IScheduler       * scheduler_;
 
     internal_state_e            internal_state_;
     element_id_t                current_state_;
+    element_id_t                initial_state_;
     element_id_t                start_action_connector_;
 
     int                         matched_switch_condition_;
 
+    bool                        is_finalized_;
+
+    bool                        is_exception_free_;
+    std::string                 error_;
+
     MapIdToState                map_id_to_state_;
     MapIdToSignalHandler        map_id_to_signal_handler_;
     MapIdToActionConnector      map_id_to_action_connector_;
     MapIdToTimer                map_id_to_timer_;
 
+    std::set<std::string>       coalesced_signals_;
+
+    // owned, linked via ev::Signal::next_saved
+    const ev::Signal            * saved_signals_head_;
+    const ev::Signal            * saved_signals_tail_;
+    bool                        is_state_changed_;
+
     utils::RequestIdGen         req_id_gen_;
 
     NamesDb                     names_;
     Memory                      mem_;
+
+    DefinitionPtr               definition_;
+
+    ExecutionProfile            * profile_;
 };
 
 } // namespace fsm
@@ -19,7 +19,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-// $Revision: 11612 $ $Date:: 2019-05-24 #$ $Author: serge $
+// $Revision: 11664 $ $Date:: 2019-06-19 #$ $Author: serge $
 
 #include "sdl_gr_helper.h"             // self
 
@@ -29,6 +29,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include <unordered_map>
 #include <map>
 #include <cassert>
+#include <algorithm>                // std::max
 
 #include "process.h"                // Process
 
@@ -41,8 +42,12 @@ namespace fsm {
 #define TUPLE_VAL_STR(_x_)  _x_,#_x_
 #define TUPLE_STR_VAL(_x_)  #_x_,_x_
 
-SdlGrHelper::SdlGrHelper( const Process * l ):
-        process_( l )
+SdlGrHelper::SdlGrHelper( const Process * l, const ExecutionProfile * profile ):
+        process_( l ),
+        profile_( profile ),
+        total_time_( 0 ),
+        max_action_connector_time_( 0 ),
+        max_signal_handler_time_( 0 )
 {
 }
 
@@ -103,12 +108,25 @@ std::ostream & SdlGrHelper::write( std::ostream & os, const State & l )
         os << "\n";
     }
 
+    unsigned i = 0;
+
+    for( auto & e : l.saved_signals_ )
+    {
+        os << "SAVE_" << l.get_id() << "_" << ++i << " [ label=\"" << e << "\" shape=sdl_save ]" << "\n";
+        write_name( os, l );
+        os << " -> SAVE_" << l.get_id() << "_" << i << "\n";
+    }
+
     return os;
 }
 
 std::ostream & SdlGrHelper::write( std::ostream & os, const Constant & l )
 {
-    os << l.get_name() << " " << anyvalue::StrHelper::to_string( l.get_type() ) << " := " << anyvalue::StrHelper::to_string_short( l.get() );
+    Value value;
+
+    l.get( & value );
+
+    os << l.get_name() << " " << anyvalue::StrHelper::to_string( l.get_type() ) << " := " << anyvalue::StrHelper::to_string_short( value );
 
     return os;
 }
@@ -118,7 +136,13 @@ std::ostream & SdlGrHelper::write( std::ostream & os, const Variable & l )
     os << l.get_name() << " " << anyvalue::StrHelper::to_string( l.get_type() );
 
     if( l.is_inited() )
-        os << " := " << anyvalue::StrHelper::to_string_short( l.get() );
+    {
+        Value value;
+
+        l.get( & value );
+
+        os << " := " << anyvalue::StrHelper::to_string_short( value );
+    }
 
     return os;
 }
@@ -176,8 +200,24 @@ std::ostream & SdlGrHelper::write_SendSignal( std::ostream & os, const Action &
     write_name( os, ac );
 
     os << " [ label=\"" << a.name << "( "
-            << StrHelperExpr( process_->mem_ ).to_string( a.arguments ) << " )"
-            << "\" shape=sdl_output_to_left fillcolor=orange ]" << "\n";
+            << StrHelperExpr( process_->mem_ ).to_string( a.arguments ) << " )";
+
+    switch( a.target )
+    {
+    case SendSignal::target_e::PROCESS:
+        os << "\\nTO " << StrHelperExpr( process_->mem_ ).to_string( a.to );
+        break;
+    case SendSignal::target_e::SELF:
+        os << "\\nTO SELF";
+        break;
+    case SendSignal::target_e::PARENT:
+        os << "\\nTO PARENT";
+        break;
+    default:
+        break;
+    }
+
+    os << "\" shape=sdl_output_to_left fillcolor=orange ]" << "\n";
 
     write_edge( os, ac.get_id(), ac.get_next_id() );
 
@@ -312,6 +352,18 @@ std::ostream & SdlGrHelper::write( std::ostream & os, const ActionConnector & l
 
     os << "\n";
 
+    element_id_t state_id;
+
+    // next state actions are drawn as edges to the state
+    if( profile_ && is_action_next_state( l.get_id(), & state_id ) == false )
+    {
+        std::ostringstream name;
+
+        write_name( name, l );
+
+        write_heat( os, name.str(), profile_->find_action_connector( l.get_id() ), max_action_connector_time_ );
+    }
+
     return os;
 }
 
@@ -330,6 +382,11 @@ std::ostream & SdlGrHelper::write( std::ostream & os )
 {
     generate_map_of_next_state_actions();
 
+    if( profile_ )
+    {
+        init_max_times();
+    }
+
     os <<
     "digraph Process\n"
     "{\n"
@@ -346,6 +403,14 @@ std::ostream & SdlGrHelper::write( std::ostream & os )
     os << "START [ shape=sdl_start ]\n";
     os << "START -> ";
     write_action_connector_name( os, process_->start_action_connector_ );
+
+    if( profile_ )
+    {
+        auto counter = profile_->find_action_connector( process_->start_action_connector_ );
+
+        os << " [ label=\"" << to_heat_label( std::string(), counter ? counter->hits : 0 ) << "\" ]";
+    }
+
     os << "\n";
 
     write_states( os );
@@ -381,6 +446,20 @@ void SdlGrHelper::write_signal_handlers( std::ostream & os )
     for( auto & e : process_->map_id_to_signal_handler_ )
     {
         write( os, * e.second );
+
+        if( profile_ )
+        {
+            auto counter = profile_->find_signal_handler( e.first );
+
+            os << " [ label=\"" << to_heat_label( std::string(), counter ? counter->hits : 0 ) << "\" ]\n";
+
+            std::ostringstream name;
+
+            write_signal_handler_name( name, e.first );
+
+            write_heat( os, name.str(), counter, max_signal_handler_time_ );
+        }
+
         os << "\n";
     }
 }
@@ -507,7 +586,11 @@ std::ostream & SdlGrHelper::write_edge( std::ostream & os, element_id_t action_c
         write_action_connector_name( os, action_connector_id_2 );
     }
 
-    if( ! comment.empty() )
+    if( profile_ )
+    {
+        os << " [ label=\"" << to_heat_label( comment, profile_->get_edge_hits( action_connector_id_1, action_connector_id_2 ) ) << "\" ]";
+    }
+    else if( ! comment.empty() )
     {
         os << " [ label=\"" << comment << "\" ]";
     }
@@ -515,6 +598,57 @@ std::ostream & SdlGrHelper::write_edge( std::ostream & os, element_id_t action_c
     return os;
 }
 
+void SdlGrHelper::init_max_times()
+{
+    for( auto & e : profile_->get_action_connectors() )
+    {
+        total_time_ += e.second.time;
+
+        max_action_connector_time_  = std::max( max_action_connector_time_, e.second.time );
+    }
+
+    for( auto & e : profile_->get_signal_handlers() )
+    {
+        max_signal_handler_time_    = std::max( max_signal_handler_time_, e.second.time );
+    }
+}
+
+std::ostream & SdlGrHelper::write_heat( std::ostream & os, const std::string & name, const ExecutionProfile::Counter * counter, ExecutionProfile::Duration max_time )
+{
+    // node is defined again, graphviz merges the attributes
+    os << name << " [ xlabel=\"";
+
+    if( counter == nullptr )
+    {
+        os << "0x\" ]\n";
+        return os;
+    }
+
+    // share of the total time of all actions, the one of a signal handler includes its whole chain
+    double share    = total_time_.count() ? 100.0 * counter->time.count() / total_time_.count() : 0;
+
+    // white - cold, red - the hottest node of its kind
+    unsigned level  = max_time.count() ? unsigned( 255 - 255.0 * counter->time.count() / max_time.count() ) : 255;
+
+    std::ostringstream attr;
+
+    attr << counter->hits << "x " << std::fixed << std::setprecision( 1 ) << share << "%\""
+            << " fillcolor=\"#ff" << std::hex << std::setfill( '0' )
+            << std::setw( 2 ) << level << std::setw( 2 ) << level << "\" ]\n";
+
+    os << attr.str();
+
+    return os;
+}
+
+std::string SdlGrHelper::to_heat_label( const std::string & comment, uint64_t hits )
+{
+    if( comment.empty() )
+        return "(" + std::to_string( hits ) + ")";
+
+    return comment + " (" + std::to_string( hits ) + ")";
+}
+
 void SdlGrHelper::generate_map_of_next_state_actions()
 {
     for( auto & e : process_->map_id_to_action_connector_ )
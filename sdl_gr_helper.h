@@ -19,7 +19,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-// $Revision: 11611 $ $Date:: 2019-05-24 #$ $Author: serge $
+// $Revision: 11645 $ $Date:: 2019-06-10 #$ $Author: serge $
 
 #ifndef LIB_FSM__SDL_GR_HELPER_H
 #define LIB_FSM__SDL_GR_HELPER_H
@@ -35,6 +35,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include "timer.h"              // Timer
 #include "action_connector.h"   // ActionConnector
 #include "signal_handler.h"     // SignalHandler
+#include "execution_profile.h"  // ExecutionProfile
 
 namespace fsm {
 
@@ -44,7 +45,8 @@ class SdlGrHelper
 {
 public:
 
-    SdlGrHelper( const Process * l );
+    // profile is optional, it colours nodes by their share of the execution time and labels edges with the number of passes
+    SdlGrHelper( const Process * l, const ExecutionProfile * profile = nullptr );
 
     static std::ostream & write_element_name( std::ostream & os, const std::string & prefix, element_id_t id );
     static std::ostream & write_action_connector_name( std::ostream & os, element_id_t id );
@@ -103,6 +105,10 @@ private:
 
     std::ostream & write_edge( std::ostream & os, element_id_t action_connector_id_1, element_id_t action_connector_id_2, const std::string & comment = std::string() );
 
+    void init_max_times();
+    std::ostream & write_heat( std::ostream & os, const std::string & name, const ExecutionProfile::Counter * counter, ExecutionProfile::Duration max_time );
+    static std::string to_heat_label( const std::string & comment, uint64_t hits );
+
     void generate_map_of_next_state_actions();
 
     bool is_action_next_state( element_id_t action_connector_id, element_id_t * state_id ) const;
@@ -111,6 +117,13 @@ private:
 
     const Process   * process_;
 
+    const ExecutionProfile  * profile_;
+
+    // for the colour scale
+    ExecutionProfile::Duration  total_time_;
+    ExecutionProfile::Duration  max_action_connector_time_;
+    ExecutionProfile::Duration  max_signal_handler_time_;
+
     MapIdToId       map_next_state_action_to_state_id_;
 };
 
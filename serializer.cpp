@@ -0,0 +1,169 @@
+/*
+
+FSM. Binary serializer.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11621 $ $Date:: 2019-05-28 #$ $Author: serge $
+
+#include "serializer.h"         // self
+
+namespace fsm {
+
+std::ostream & Serializer::save( std::ostream & os, uint8_t v )
+{
+    return save_raw( os, v );
+}
+
+std::ostream & Serializer::save( std::ostream & os, uint32_t v )
+{
+    return save_raw( os, v );
+}
+
+std::ostream & Serializer::save( std::ostream & os, uint64_t v )
+{
+    return save_raw( os, v );
+}
+
+std::ostream & Serializer::save( std::ostream & os, int64_t v )
+{
+    return save_raw( os, v );
+}
+
+std::ostream & Serializer::save( std::ostream & os, double v )
+{
+    return save_raw( os, v );
+}
+
+std::ostream & Serializer::save( std::ostream & os, const std::string & v )
+{
+    save( os, uint32_t( v.size() ) );
+
+    return os.write( v.data(), v.size() );
+}
+
+std::ostream & Serializer::save( std::ostream & os, const Value & v )
+{
+    save( os, uint8_t( v.type ) );
+
+    switch( v.type )
+    {
+    case data_type_e::BOOL:
+        save( os, uint8_t( v.arg_b ) );
+        break;
+    case data_type_e::INT:
+        save( os, int64_t( v.arg_i ) );
+        break;
+    case data_type_e::DOUBLE:
+        save( os, double( v.arg_d ) );
+        break;
+    case data_type_e::STRING:
+        save( os, v.arg_s );
+        break;
+    default:
+        break;
+    }
+
+    return os;
+}
+
+bool Serializer::load( uint8_t * v, std::istream & is )
+{
+    return load_raw( v, is );
+}
+
+bool Serializer::load( uint32_t * v, std::istream & is )
+{
+    return load_raw( v, is );
+}
+
+bool Serializer::load( uint64_t * v, std::istream & is )
+{
+    return load_raw( v, is );
+}
+
+bool Serializer::load( int64_t * v, std::istream & is )
+{
+    return load_raw( v, is );
+}
+
+bool Serializer::load( double * v, std::istream & is )
+{
+    return load_raw( v, is );
+}
+
+bool Serializer::load( std::string * v, std::istream & is )
+{
+    uint32_t size;
+
+    if( load( & size, is ) == false )
+        return false;
+
+    v->resize( size );
+
+    if( size == 0 )
+        return true;
+
+    return static_cast<bool>( is.read( & ( * v )[0], size ) );
+}
+
+bool Serializer::load( Value * v, std::istream & is )
+{
+    uint8_t type;
+
+    if( load( & type, is ) == false )
+        return false;
+
+    * v         = Value();
+    v->type     = data_type_e( type );
+
+    switch( v->type )
+    {
+    case data_type_e::UNDEF:
+        return true;
+
+    case data_type_e::BOOL:
+    {
+        uint8_t b;
+        if( load( & b, is ) == false )
+            return false;
+        v->arg_b = ( b != 0 );
+        return true;
+    }
+
+    case data_type_e::INT:
+    {
+        int64_t i;
+        if( load( & i, is ) == false )
+            return false;
+        v->arg_i = i;
+        return true;
+    }
+
+    case data_type_e::DOUBLE:
+        return load( & v->arg_d, is );
+
+    case data_type_e::STRING:
+        return load( & v->arg_s, is );
+
+    default:
+        return false;
+    }
+}
+
+} // namespace fsm
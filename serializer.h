@@ -0,0 +1,77 @@
+/*
+
+FSM. Binary serializer.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11621 $ $Date:: 2019-05-28 #$ $Author: serge $
+
+#ifndef LIB_FSM__SERIALIZER_H
+#define LIB_FSM__SERIALIZER_H
+
+#include <cstdint>              // uint32_t
+#include <string>               // std::string
+#include <ostream>              // std::ostream
+#include <istream>              // std::istream
+
+#include "elements.h"           // Value
+
+namespace fsm {
+
+// host byte order, snapshots are not meant to be moved between different architectures
+class Serializer
+{
+public:
+
+    // upper bound of a stored number of signal arguments, a corrupt snapshot or journal must not allocate a huge vector
+    static const uint32_t MAX_NUM_ARGUMENTS    = 0x10000;
+
+    static std::ostream & save( std::ostream & os, uint8_t v );
+    static std::ostream & save( std::ostream & os, uint32_t v );
+    static std::ostream & save( std::ostream & os, uint64_t v );
+    static std::ostream & save( std::ostream & os, int64_t v );
+    static std::ostream & save( std::ostream & os, double v );
+    static std::ostream & save( std::ostream & os, const std::string & v );
+    static std::ostream & save( std::ostream & os, const Value & v );
+
+    static bool load( uint8_t * v, std::istream & is );
+    static bool load( uint32_t * v, std::istream & is );
+    static bool load( uint64_t * v, std::istream & is );
+    static bool load( int64_t * v, std::istream & is );
+    static bool load( double * v, std::istream & is );
+    static bool load( std::string * v, std::istream & is );
+    static bool load( Value * v, std::istream & is );
+
+private:
+
+    template<class T>
+    static std::ostream & save_raw( std::ostream & os, const T & v )
+    {
+        return os.write( reinterpret_cast<const char*>( & v ), sizeof( v ) );
+    }
+
+    template<class T>
+    static bool load_raw( T * v, std::istream & is )
+    {
+        return static_cast<bool>( is.read( reinterpret_cast<char*>( v ), sizeof( * v ) ) );
+    }
+};
+
+} // namespace fsm
+
+#endif // LIB_FSM__SERIALIZER_H
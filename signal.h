@@ -19,7 +19,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-// $Revision: 11611 $ $Date:: 2019-05-24 #$ $Author: serge $
+// $Revision: 11676 $ $Date:: 2019-06-26 #$ $Author: serge $
 
 #ifndef LIB_FSM__SIGNAL_H
 #define LIB_FSM__SIGNAL_H
@@ -38,13 +38,75 @@ struct Signal: public Object
     Signal( uint32_t process_id, const std::string & name, const std::vector<Value> & arguments ):
         process_id( process_id ),
         name( name ),
-        arguments( arguments )
+        arguments( arguments ),
+        next_saved( nullptr )
+    {
+    }
+
+    Signal( uint32_t process_id, const std::string & name, std::vector<Value> && arguments ):
+        process_id( process_id ),
+        name( name ),
+        arguments( std::move( arguments ) ),
+        next_saved( nullptr )
     {
     }
 
     uint32_t                        process_id;
     std::string                     name;
     std::vector<Value>              arguments;
+
+    // intrusive list of signals saved by a process, see Process::add_saved_signal()
+    mutable const Signal            * next_saved;
+};
+
+// the signal is handled by all targeted processes in one pass, its arguments are shared, see FsmManager::join_group()
+struct Broadcast: public Object
+{
+    enum class target_e
+    {
+        ALL,
+        DEFINITION,
+        GROUP
+    };
+
+    // target_name - name of the definition or of the group, is ignored for ALL
+    Broadcast( target_e target, const std::string & target_name, const std::string & name, const std::vector<Value> & arguments ):
+        target( target ),
+        target_name( target_name ),
+        signal( 0, name, arguments )
+    {
+    }
+
+    Broadcast( target_e target, const std::string & target_name, const std::string & name, std::vector<Value> && arguments ):
+        target( target ),
+        target_name( target_name ),
+        signal( 0, name, std::move( arguments ) )
+    {
+    }
+
+    target_e                        target;
+    std::string                     target_name;
+    Signal                          signal;
+};
+
+// the signal is addressed by the correlation key of the process, the key is resolved when the event is handled,
+// see FsmManager::set_correlation_key()
+struct KeySignal: public Object
+{
+    KeySignal( const std::string & correlation_key, const std::string & name, const std::vector<Value> & arguments ):
+        correlation_key( correlation_key ),
+        signal( 0, name, arguments )
+    {
+    }
+
+    KeySignal( const std::string & correlation_key, const std::string & name, std::vector<Value> && arguments ):
+        correlation_key( correlation_key ),
+        signal( 0, name, std::move( arguments ) )
+    {
+    }
+
+    std::string                     correlation_key;
+    Signal                          signal;
 };
 
 } // namespace ev
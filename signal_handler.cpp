@@ -26,6 +26,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include <cassert>                  // assert
 
 #include "utils/dummy_logger.h"     // dummy_log_debug
+#include "size_helper.h"            // SizeHelper
 
 namespace fsm {
 
@@ -53,4 +54,9 @@ element_id_t SignalHandler::get_first_action_id() const
     return first_action_id_;
 }
 
+std::size_t SignalHandler::get_memory_usage() const
+{
+    return sizeof( * this ) + SizeHelper::get_size( name_ );
+}
+
 } // namespace fsm
@@ -36,6 +36,8 @@ public:
     void set_first_action_id( element_id_t id );
     element_id_t get_first_action_id() const;
 
+    std::size_t get_memory_usage() const;
+
 private:
     SignalHandler( const SignalHandler & )              = delete;
     SignalHandler & operator=( const SignalHandler & )  = delete;
@@ -0,0 +1,272 @@
+/*
+
+FSM. Size helper.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11664 $ $Date:: 2019-06-19 #$ $Author: serge $
+
+#include "size_helper.h"        // self
+
+#include <cassert>              // assert
+#include <typeindex>            // std::type_index
+#include <typeinfo>
+#include <unordered_map>
+
+#include "actions.h"            // SendSignal, ...
+#include "syntax_error.h"       // SyntaxError
+
+namespace fsm {
+
+std::size_t SizeHelper::get_size( const std::string & s )
+{
+    static const auto sso_capacity = std::string().capacity();
+
+    return ( s.capacity() > sso_capacity ) ? s.capacity() + 1 : 0;
+}
+
+std::size_t SizeHelper::get_size( const Value & v )
+{
+    return get_size( v.arg_s );
+}
+
+std::size_t SizeHelper::get_size( const ExpressionPtr & expr )
+{
+    if( expr == nullptr )
+        return 0;
+
+    return get_size( * expr.get() );
+}
+
+std::size_t SizeHelper::get_size( const Expression & expr )
+{
+    typedef std::size_t (*PPMF)( const Expression & );
+
+#define MAP_ENTRY(_v)       { typeid( _v ),        & SizeHelper::get_size_##_v }
+
+    static const std::unordered_map<std::type_index, PPMF> funcs =
+    {
+        MAP_ENTRY( ExpressionValue ),
+        MAP_ENTRY( ExpressionVariable ),
+        MAP_ENTRY( ExpressionVariableName ),
+        MAP_ENTRY( UnaryExpression ),
+        MAP_ENTRY( BinaryExpression ),
+    };
+
+#undef MAP_ENTRY
+
+    auto it = funcs.find( typeid( expr ) );
+
+    if( it == funcs.end() )
+    {
+        assert( 0 );
+        throw SyntaxError( "unsupported expression type " + std::string( typeid( expr ).name() ) );
+    }
+
+    return it->second( expr );
+}
+
+std::size_t SizeHelper::get_size( const Action & action )
+{
+    typedef std::size_t (*PPMF)( const Action & );
+
+#define MAP_ENTRY(_v)       { typeid( _v ),        & SizeHelper::get_size_##_v }
+
+    static const std::unordered_map<std::type_index, PPMF> funcs =
+    {
+        MAP_ENTRY( SendSignal ),
+        MAP_ENTRY( SetTimer ),
+        MAP_ENTRY( ResetTimer ),
+        MAP_ENTRY( FunctionCall ),
+        MAP_ENTRY( Task ),
+        MAP_ENTRY( Condition ),
+        MAP_ENTRY( SwitchCondition ),
+        MAP_ENTRY( NextState ),
+        MAP_ENTRY( Exit ),
+    };
+
+#undef MAP_ENTRY
+
+    auto it = funcs.find( typeid( action ) );
+
+    if( it == funcs.end() )
+    {
+        assert( 0 );
+        throw SyntaxError( "unsupported action type " + std::string( typeid( action ).name() ) );
+    }
+
+    return it->second( action );
+}
+
+std::size_t SizeHelper::get_size( const std::vector<ExpressionPtr> & l )
+{
+    std::size_t res = l.capacity() * sizeof( ExpressionPtr );
+
+    for( auto & e : l )
+    {
+        res += get_size( e );
+    }
+
+    return res;
+}
+
+std::size_t SizeHelper::get_size( const std::vector<std::pair<bool,ExpressionPtr>> & l )
+{
+    std::size_t res = l.capacity() * sizeof( std::pair<bool,ExpressionPtr> );
+
+    for( auto & e : l )
+    {
+        res += get_size( e.second );
+    }
+
+    return res;
+}
+
+std::size_t SizeHelper::get_size( const ArgumentCachePtr & cache )
+{
+    if( cache == nullptr )
+        return 0;
+
+    std::size_t res = sizeof( ArgumentCache ) + cache->values.capacity() * sizeof( Value ) + cache->variable_slots.capacity() * sizeof( unsigned );
+
+    for( auto & e : cache->values )
+    {
+        res += get_size( e );
+    }
+
+    return res;
+}
+
+std::size_t SizeHelper::get_size( const SwitchTablePtr & table )
+{
+    if( table == nullptr )
+        return 0;
+
+    // buckets are not counted
+    std::size_t res = sizeof( SwitchTable )
+            + table->map_int_to_case.size() * ( sizeof( void* ) + sizeof( std::pair<int64_t,int> ) )
+            + table->map_double_to_case.size() * ( sizeof( void* ) + sizeof( std::pair<double,int> ) );
+
+    for( auto & e : table->map_string_to_case )
+    {
+        res += sizeof( void* ) + sizeof( e ) + get_size( e.first );
+    }
+
+    return res;
+}
+
+std::size_t SizeHelper::get_size_ExpressionValue( const Expression & eexpr )
+{
+    auto & a = dynamic_cast< const ExpressionValue &>( eexpr );
+
+    // interned strings are counted at each reference
+    return sizeof( a ) + a.value.get_heap_size();
+}
+
+std::size_t SizeHelper::get_size_ExpressionVariable( const Expression & eexpr )
+{
+    auto & a = dynamic_cast< const ExpressionVariable &>( eexpr );
+
+    return sizeof( a );
+}
+
+std::size_t SizeHelper::get_size_ExpressionVariableName( const Expression & eexpr )
+{
+    auto & a = dynamic_cast< const ExpressionVariableName &>( eexpr );
+
+    return sizeof( a ) + get_size( a.variable_name );
+}
+
+std::size_t SizeHelper::get_size_UnaryExpression( const Expression & eexpr )
+{
+    auto & a = dynamic_cast< const UnaryExpression &>( eexpr );
+
+    return sizeof( a ) + get_size( a.op );
+}
+
+std::size_t SizeHelper::get_size_BinaryExpression( const Expression & eexpr )
+{
+    auto & a = dynamic_cast< const BinaryExpression &>( eexpr );
+
+    return sizeof( a ) + get_size( a.lhs ) + get_size( a.rhs );
+}
+
+std::size_t SizeHelper::get_size_SendSignal( const Action & aa )
+{
+    auto & a = dynamic_cast< const SendSignal &>( aa );
+
+    return sizeof( a ) + get_size( a.to ) + get_size( a.name ) + get_size( a.arguments ) + get_size( a.cache );
+}
+
+std::size_t SizeHelper::get_size_SetTimer( const Action & aa )
+{
+    auto & a = dynamic_cast< const SetTimer &>( aa );
+
+    return sizeof( a ) + get_size( a.delay );
+}
+
+std::size_t SizeHelper::get_size_ResetTimer( const Action & aa )
+{
+    auto & a = dynamic_cast< const ResetTimer &>( aa );
+
+    return sizeof( a );
+}
+
+std::size_t SizeHelper::get_size_FunctionCall( const Action & aa )
+{
+    auto & a = dynamic_cast< const FunctionCall &>( aa );
+
+    return sizeof( a ) + get_size( a.name ) + get_size( a.arguments ) + get_size( a.cache );
+}
+
+std::size_t SizeHelper::get_size_Task( const Action & aa )
+{
+    auto & a = dynamic_cast< const Task &>( aa );
+
+    return sizeof( a ) + get_size( a.expr );
+}
+
+std::size_t SizeHelper::get_size_Condition( const Action & aa )
+{
+    auto & a = dynamic_cast< const Condition &>( aa );
+
+    return sizeof( a ) + get_size( a.lhs ) + get_size( a.rhs );
+}
+
+std::size_t SizeHelper::get_size_SwitchCondition( const Action & aa )
+{
+    auto & a = dynamic_cast< const SwitchCondition &>( aa );
+
+    return sizeof( a ) + get_size( a.var ) + get_size( a.values ) + get_size( a.table );
+}
+
+std::size_t SizeHelper::get_size_NextState( const Action & aa )
+{
+    auto & a = dynamic_cast< const NextState &>( aa );
+
+    return sizeof( a );
+}
+
+std::size_t SizeHelper::get_size_Exit( const Action & aa )
+{
+    auto & a = dynamic_cast< const Exit &>( aa );
+
+    return sizeof( a );
+}
+
+} // namespace fsm
@@ -0,0 +1,81 @@
+/*
+
+FSM. Size helper.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11628 $ $Date:: 2019-05-31 #$ $Author: serge $
+
+#ifndef LIB_FSM__SIZE_HELPER_H
+#define LIB_FSM__SIZE_HELPER_H
+
+#include <cstddef>              // std::size_t
+#include <string>               // std::string
+#include <vector>               // std::vector
+
+#include "elements.h"           // Value, Action
+#include "expression.h"         // Expression
+#include "actions.h"            // ArgumentCache
+
+namespace fsm {
+
+// approximate number of bytes used by elements, shared expressions are counted at each reference
+class SizeHelper
+{
+public:
+
+    // approximate overhead of a node of std::map
+    static const std::size_t MAP_NODE_OVERHEAD  = 4 * sizeof( void* );
+
+    // heap allocated part only
+    static std::size_t get_size( const std::string & s );
+    static std::size_t get_size( const Value & v );
+
+    // including the object itself
+    static std::size_t get_size( const ExpressionPtr & expr );
+    static std::size_t get_size( const Expression & expr );
+    static std::size_t get_size( const Action & action );
+
+    // including the elements
+    static std::size_t get_size( const std::vector<ExpressionPtr> & l );
+    static std::size_t get_size( const std::vector<std::pair<bool,ExpressionPtr>> & l );
+    static std::size_t get_size( const ArgumentCachePtr & cache );
+    static std::size_t get_size( const SwitchTablePtr & table );
+
+private:
+
+    static std::size_t get_size_ExpressionValue( const Expression & expr );
+    static std::size_t get_size_ExpressionVariable( const Expression & expr );
+    static std::size_t get_size_ExpressionVariableName( const Expression & expr );
+    static std::size_t get_size_UnaryExpression( const Expression & expr );
+    static std::size_t get_size_BinaryExpression( const Expression & expr );
+
+    static std::size_t get_size_SendSignal( const Action & action );
+    static std::size_t get_size_SetTimer( const Action & action );
+    static std::size_t get_size_ResetTimer( const Action & action );
+    static std::size_t get_size_FunctionCall( const Action & action );
+    static std::size_t get_size_Task( const Action & action );
+    static std::size_t get_size_Condition( const Action & action );
+    static std::size_t get_size_SwitchCondition( const Action & action );
+    static std::size_t get_size_NextState( const Action & action );
+    static std::size_t get_size_Exit( const Action & action );
+};
+
+} // namespace fsm
+
+#endif // LIB_FSM__SIZE_HELPER_H
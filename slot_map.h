@@ -0,0 +1,400 @@
+/*
+
+FSM. Table of slots addressed by generation-tagged ids.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11672 $ $Date:: 2019-06-24 #$ $Author: serge $
+
+#ifndef LIB_FSM__SLOT_MAP_H
+#define LIB_FSM__SLOT_MAP_H
+
+#include <algorithm>            // std::max
+#include <cstdint>              // uint32_t
+#include <deque>                // std::deque
+#include <iterator>             // std::forward_iterator_tag
+#include <type_traits>          // std::conditional
+#include <utility>              // std::pair
+#include <vector>               // std::vector
+
+namespace fsm {
+
+// map with O(1) lookup, id = tag | generation << INDEX_BITS | index of the slot,
+// the generation of a slot is incremented when its entry is erased, so a stale id is not found,
+// a slot is retired instead of wrapping its generation, so an id is never issued twice,
+// freed slots are reused in FIFO order, id 0 is never used,
+// iterators are ordered by the index, erase() invalidates only the erased one, insert() invalidates all
+template<class T>
+class SlotMap
+{
+public:
+
+    static const uint32_t INDEX_BITS        = 20;
+    static const uint32_t GENERATION_BITS   = 11;
+
+    static const uint32_t INDEX_MASK        = ( 1u << INDEX_BITS ) - 1;
+    static const uint32_t GENERATION_MASK   = ( 1u << GENERATION_BITS ) - 1;
+    // generation of a slot that is not reused, it doesn't match any id
+    static const uint32_t RETIRED_GENERATION    = GENERATION_MASK + 1;
+    // ids of different maps don't overlap if they have different tags
+    static const uint32_t TAG_MASK          = ~( ( 1u << ( INDEX_BITS + GENERATION_BITS ) ) - 1 );
+
+    typedef std::pair<uint32_t,T>   value_type;
+
+private:
+
+    struct Slot
+    {
+        value_type      value;
+        uint32_t        generation;
+        bool            is_used;
+    };
+
+    typedef std::vector<Slot>       Slots;
+
+    template<bool IS_CONST>
+    class Iterator
+    {
+    public:
+
+        typedef std::forward_iterator_tag   iterator_category;
+        typedef typename SlotMap::value_type    value_type;
+        typedef std::ptrdiff_t              difference_type;
+        typedef typename std::conditional<IS_CONST, const value_type *, value_type *>::type pointer;
+        typedef typename std::conditional<IS_CONST, const value_type &, value_type &>::type reference;
+
+        typedef typename std::conditional<IS_CONST, typename Slots::const_iterator, typename Slots::iterator>::type SlotIterator;
+
+        Iterator( SlotIterator it, SlotIterator end ):
+            it_( it ),
+            end_( end )
+        {
+            skip_unused();
+        }
+
+        // iterator to const_iterator
+        template<bool IS_OTHER_CONST, class = typename std::enable_if<IS_CONST && IS_OTHER_CONST == false>::type>
+        Iterator( const Iterator<IS_OTHER_CONST> & other ):
+            it_( other.it_ ),
+            end_( other.end_ )
+        {
+        }
+
+        reference operator*() const
+        {
+            return it_->value;
+        }
+
+        pointer operator->() const
+        {
+            return & it_->value;
+        }
+
+        Iterator & operator++()
+        {
+            ++it_;
+            skip_unused();
+            return * this;
+        }
+
+        Iterator operator++( int )
+        {
+            auto res = * this;
+            ++( * this );
+            return res;
+        }
+
+        bool operator==( const Iterator & rhs ) const
+        {
+            return it_ == rhs.it_;
+        }
+
+        bool operator!=( const Iterator & rhs ) const
+        {
+            return it_ != rhs.it_;
+        }
+
+    private:
+
+        friend class SlotMap;
+        friend class Iterator<true>;
+
+        void skip_unused()
+        {
+            while( it_ != end_ && it_->is_used == false )
+                ++it_;
+        }
+
+        SlotIterator    it_;
+        SlotIterator    end_;
+    };
+
+public:
+
+    typedef Iterator<false>     iterator;
+    typedef Iterator<true>      const_iterator;
+
+public:
+
+    explicit SlotMap( uint32_t tag = 0 ):
+        tag_( tag & TAG_MASK ),
+        size_( 0 )
+    {
+        // slot 0 is reserved, so that id 0 is invalid
+        slots_.push_back( Slot { value_type( 0, T() ), 0, false } );
+    }
+
+    // id of the next insert( value ), 0 - there are no free slots
+    uint32_t get_next_id() const
+    {
+        if( free_indices_.empty() == false )
+        {
+            auto index = free_indices_.front();
+
+            return to_id( index, slots_[ index ].generation );
+        }
+
+        if( slots_.size() > INDEX_MASK )
+            return 0;
+
+        return to_id( uint32_t( slots_.size() ), 0 );
+    }
+
+    // returns the id of the value, 0 - there are no free slots
+    uint32_t insert( const T & value )
+    {
+        auto id = get_next_id();
+
+        if( id == 0 )
+            return 0;
+
+        insert( std::make_pair( id, value ) );
+
+        return id;
+    }
+
+    // inserts the value with the given id, e.g. of a restored entry, fails if the slot is used or the id is not of this map
+    std::pair<iterator,bool> insert( const value_type & value )
+    {
+        auto id     = value.first;
+        auto index  = id & INDEX_MASK;
+
+        if( index == 0 || ( id & TAG_MASK ) != tag_ )
+            return std::make_pair( end(), false );
+
+        while( slots_.size() <= index )
+        {
+            free_indices_.push_back( uint32_t( slots_.size() ) );
+
+            slots_.push_back( Slot { value_type( 0, T() ), 0, false } );
+        }
+
+        auto & slot = slots_[ index ];
+
+        if( slot.is_used )
+            return std::make_pair( iterator( slots_.begin() + index, slots_.end() ), false );
+
+        slot.value      = value;
+        slot.generation = ( id >> INDEX_BITS ) & GENERATION_MASK;
+        slot.is_used    = true;
+
+        ++size_;
+
+        // the used slot may be anywhere in the free list, it is skipped once it is at the front
+        while( free_indices_.empty() == false && slots_[ free_indices_.front() ].is_used )
+            free_indices_.pop_front();
+
+        return std::make_pair( iterator( slots_.begin() + index, slots_.end() ), true );
+    }
+
+    iterator find( uint32_t id )
+    {
+        return iterator( find_slot( id ), slots_.end() );
+    }
+
+    const_iterator find( uint32_t id ) const
+    {
+        return const_iterator( const_cast<SlotMap*>( this )->find_slot( id ), slots_.end() );
+    }
+
+    std::size_t count( uint32_t id ) const
+    {
+        return find( id ) == end() ? 0 : 1;
+    }
+
+    void erase( iterator it )
+    {
+        release( uint32_t( it.it_ - slots_.begin() ) );
+
+        --size_;
+    }
+
+    // the slots are kept, so that ids issued before are not reused with the same generation
+    void clear()
+    {
+        free_indices_.clear();
+
+        for( uint32_t index = 1; index < slots_.size(); ++index )
+        {
+            if( slots_[ index ].is_used )
+                release( index );
+            else if( slots_[ index ].generation != RETIRED_GENERATION )
+                free_indices_.push_back( index );
+        }
+
+        size_   = 0;
+    }
+
+    // generation of each slot incl. free and retired ones, to be persisted with the entries
+    std::vector<uint32_t> get_generations() const
+    {
+        std::vector<uint32_t> res;
+
+        res.reserve( slots_.size() );
+
+        for( auto & slot : slots_ )
+            res.push_back( slot.generation );
+
+        return res;
+    }
+
+    // restores the generations, e.g. before restored entries are inserted, so that ids issued before are not reissued,
+    // the generations are only raised, ids of the used slots stay valid, fails if the generations are invalid
+    bool set_generations( const std::vector<uint32_t> & generations )
+    {
+        if( generations.size() > INDEX_MASK + 1 )
+            return false;
+
+        for( auto g : generations )
+        {
+            if( g > RETIRED_GENERATION )
+                return false;
+        }
+
+        while( slots_.size() < generations.size() )
+            slots_.push_back( Slot { value_type( 0, T() ), 0, false } );
+
+        free_indices_.clear();
+
+        for( uint32_t index = 1; index < slots_.size(); ++index )
+        {
+            auto & slot = slots_[ index ];
+
+            if( index < generations.size() )
+                slot.generation = std::max( slot.generation, generations[ index ] );
+
+            if( slot.is_used == false && slot.generation != RETIRED_GENERATION )
+                free_indices_.push_back( index );
+        }
+
+        return true;
+    }
+
+    iterator begin()
+    {
+        return iterator( slots_.begin(), slots_.end() );
+    }
+
+    iterator end()
+    {
+        return iterator( slots_.end(), slots_.end() );
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator( slots_.begin(), slots_.end() );
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator( slots_.end(), slots_.end() );
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    // number of allocated slots, incl. free and retired ones
+    std::size_t get_capacity() const
+    {
+        return slots_.size();
+    }
+
+private:
+
+    // the next generation is used by the next entry, the top one retires the slot
+    void release( uint32_t index )
+    {
+        auto & slot = slots_[ index ];
+
+        slot.value      = value_type( 0, T() );
+        slot.is_used    = false;
+
+        if( slot.generation < GENERATION_MASK )
+        {
+            ++slot.generation;
+
+            free_indices_.push_back( index );
+        }
+        else
+        {
+            slot.generation = RETIRED_GENERATION;
+        }
+    }
+
+    uint32_t to_id( uint32_t index, uint32_t generation ) const
+    {
+        return tag_ | ( generation << INDEX_BITS ) | index;
+    }
+
+    typename Slots::iterator find_slot( uint32_t id )
+    {
+        auto index = id & INDEX_MASK;
+
+        if( index >= slots_.size() )
+            return slots_.end();
+
+        auto it = slots_.begin() + index;
+
+        if( it->is_used == false || it->value.first != id )
+            return slots_.end();
+
+        return it;
+    }
+
+private:
+
+    uint32_t                tag_;
+
+    Slots                   slots_;
+
+    // FIFO, so that a slot and its generation are reused as late as possible
+    std::deque<uint32_t>    free_indices_;
+
+    std::size_t             size_;
+};
+
+} // namespace fsm
+
+#endif // LIB_FSM__SLOT_MAP_H
@@ -19,13 +19,14 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-// $Revision: 10640 $ $Date:: 2019-03-13 #$ $Author: serge $
+// $Revision: 11660 $ $Date:: 2019-06-17 #$ $Author: serge $
 
 #include "state.h"              // self
 
 #include <cassert>              // assert
 
 #include "utils/dummy_logger.h"     // dummy_logi_debug
+#include "size_helper.h"            // SizeHelper
 
 namespace fsm {
 
@@ -56,6 +57,13 @@ void State::add_signal_handler( const std::string & signal_name, element_id_t si
     }
 }
 
+void State::add_saved_signal( const std::string & signal_name )
+{
+    dummy_logi_debug( log_id_, process_id_, "added saved signal: state %s (%u), signal %s", name_.c_str(), id_, signal_name.c_str() );
+
+    saved_signals_.insert( signal_name );
+}
+
 void State::handle_signal( const std::string & signal_name, const std::vector<element_id_t> & arguments )
 {
     auto it = map_signal_name_to_signal_handler_ids_.find( signal_name );
@@ -76,4 +84,39 @@ void State::handle_signal( const std::string & signal_name, const std::vector<el
     }
 }
 
+bool State::has_signal_handler( const std::string & signal_name ) const
+{
+    return map_signal_name_to_signal_handler_ids_.count( signal_name ) != 0;
+}
+
+bool State::is_saved( const std::string & signal_name ) const
+{
+    if( saved_signals_.empty() || saved_signals_.count( signal_name ) == 0 )
+        return false;
+
+    return has_signal_handler( signal_name ) == false;
+}
+
+void State::set_process_id( uint32_t process_id )
+{
+    process_id_ = process_id;
+}
+
+std::size_t State::get_memory_usage() const
+{
+    std::size_t res = sizeof( * this ) + SizeHelper::get_size( name_ );
+
+    for( auto & e : map_signal_name_to_signal_handler_ids_ )
+    {
+        res += SizeHelper::MAP_NODE_OVERHEAD + sizeof( e ) + SizeHelper::get_size( e.first );
+    }
+
+    for( auto & e : saved_signals_ )
+    {
+        res += SizeHelper::MAP_NODE_OVERHEAD + sizeof( e ) + SizeHelper::get_size( e );
+    }
+
+    return res;
+}
+
 } // namespace fsm
@@ -19,12 +19,13 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 */
 
-// $Revision: 10392 $ $Date:: 2019-01-04 #$ $Author: serge $
+// $Revision: 11660 $ $Date:: 2019-06-17 #$ $Author: serge $
 
 #ifndef LIB_FSM__STATE_H
 #define LIB_FSM__STATE_H
 
 #include <map>                  // std::map
+#include <set>                  // std::set
 
 #include "actions.h"            // Actions
 #include "i_signal_handler.h"   // ISignalHandler
@@ -34,14 +35,26 @@ namespace fsm {
 class State: public NamedElement
 {
     friend class SdlGrHelper;
+    friend class CppGenHelper;
+    friend class Process;
 
 public:
     State( uint32_t log_id, element_id_t id, uint32_t process_id, const std::string & name, ISignalHandler * handler );
 
     void add_signal_handler( const std::string & signal_name, element_id_t signal_handler_id );
 
+    // SDL SAVE, the signal is kept by the process until a state handles it, a signal handler takes precedence
+    void add_saved_signal( const std::string & signal_name );
+
     void handle_signal( const std::string & signal_name, const std::vector<element_id_t> & arguments );
 
+    bool has_signal_handler( const std::string & signal_name ) const;
+    bool is_saved( const std::string & signal_name ) const;
+
+    void set_process_id( uint32_t process_id );
+
+    std::size_t get_memory_usage() const;
+
 private:
     State( const State & )              = delete;
     State & operator=( const State & )  = delete;
@@ -54,6 +67,8 @@ private:
     ISignalHandler                          * handler_;
 
     std::map<std::string,element_id_t>      map_signal_name_to_signal_handler_ids_;
+
+    std::set<std::string>                   saved_signals_;
 };
 
 } // namespace fsm
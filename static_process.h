@@ -0,0 +1,301 @@
+/*
+
+FSM. Process defined at compile time.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11641 $ $Date:: 2019-06-07 #$ $Author: serge $
+
+#ifndef LIB_FSM__STATIC_PROCESS_H
+#define LIB_FSM__STATIC_PROCESS_H
+
+#include <array>                // std::array
+#include <string>               // std::string
+#include <unordered_map>        // std::unordered_map
+#include <type_traits>          // std::is_same
+
+#include "native_process.h"     // NativeProcess
+
+namespace fsm {
+
+namespace dsl {
+
+template<class... T>
+struct List
+{
+};
+
+// targets of a transition besides states
+struct Stay {};
+struct Exit {};
+
+// goes to THEN if COND()( process ) is true, otherwise to ELSE, can be nested
+template<class COND, class THEN, class ELSE>
+struct Select {};
+
+struct NoAction
+{
+    template<class PROCESS>
+    void operator()( PROCESS & ) const
+    {
+    }
+};
+
+// on SIGNAL in STATE calls ACTION()( process ) and goes to NEXT
+template<class STATE, class SIGNAL, class ACTION, class NEXT>
+struct Transition
+{
+    typedef STATE   state;
+    typedef SIGNAL  signal;
+    typedef ACTION  action;
+    typedef NEXT    next;
+};
+
+template<class T, class LIST>
+struct IndexOf;
+
+template<class T, class... R>
+struct IndexOf<T, List<T, R...>>
+{
+    static const unsigned value = 0;
+};
+
+template<class T, class H, class... R>
+struct IndexOf<T, List<H, R...>>
+{
+    static const unsigned value = 1 + IndexOf<T, List<R...>>::value;
+};
+
+template<class T>
+struct IndexOf<T, List<>>
+{
+    static_assert( sizeof( T ) == 0, "type is not in the list of states or signals" );
+};
+
+// first transition of STATE on SIGNAL, void if there is none
+template<class STATE, class SIGNAL, class LIST>
+struct Find;
+
+template<class STATE, class SIGNAL>
+struct Find<STATE, SIGNAL, List<>>
+{
+    typedef void type;
+};
+
+template<class STATE, class SIGNAL, class H, class... R>
+struct Find<STATE, SIGNAL, List<H, R...>>
+{
+    typedef typename std::conditional<
+            std::is_same<typename H::state, STATE>::value && std::is_same<typename H::signal, SIGNAL>::value,
+            H,
+            typename Find<STATE, SIGNAL, List<R...>>::type>::type type;
+};
+
+} // namespace dsl
+
+// defines a signal or a timer of a static process, the name is the one of ev::Signal
+#define FSM_DSL_SIGNAL(_name_)      struct _name_ { static const char * name() { return #_name_; } }
+
+// base of processes whose states, signals and transitions are types, DERIVED provides:
+//   typedef dsl::List<...> states;          the first one is the initial state
+//   typedef dsl::List<...> signals;         types defined by FSM_DSL_SIGNAL
+//   typedef dsl::List<...> transitions;     dsl::Transition<>
+//   optional void on_start();
+// actions and conditions are types nested in DERIVED, i.e. they have access to its members
+template<class DERIVED>
+class StaticProcess: public NativeProcess
+{
+public:
+
+    StaticProcess(
+            uint32_t                id,
+            uint32_t                log_id,
+            IFsm                    * parent,
+            ICallback               * callback,
+            scheduler::IScheduler   * scheduler ):
+            NativeProcess( id, log_id, parent, callback, scheduler ),
+            state_( 0 )
+    {
+    }
+
+    static NativeProcess* create( uint32_t id, uint32_t log_id, IFsm * parent, ICallback * callback, scheduler::IScheduler * scheduler )
+    {
+        return new DERIVED( id, log_id, parent, callback, scheduler );
+    }
+
+    void start() override
+    {
+        static_cast<DERIVED*>( this )->on_start();
+    }
+
+protected:
+
+    void on_start()
+    {
+    }
+
+    unsigned get_state() const
+    {
+        return state_;
+    }
+
+private:
+
+    typedef void (*Handler)( DERIVED & process );
+
+    template<class NEXT, class DUMMY = void>
+    struct Goto
+    {
+        static void apply( DERIVED & process )
+        {
+            static_cast<StaticProcess &>( process ).state_ = dsl::IndexOf<NEXT, typename DERIVED::states>::value;
+        }
+    };
+
+    template<class DUMMY>
+    struct Goto<dsl::Stay, DUMMY>
+    {
+        static void apply( DERIVED & )
+        {
+        }
+    };
+
+    template<class DUMMY>
+    struct Goto<dsl::Exit, DUMMY>
+    {
+        static void apply( DERIVED & process )
+        {
+            static_cast<StaticProcess &>( process ).set_ended();
+        }
+    };
+
+    template<class COND, class THEN, class ELSE, class DUMMY>
+    struct Goto<dsl::Select<COND, THEN, ELSE>, DUMMY>
+    {
+        static void apply( DERIVED & process )
+        {
+            if( COND()( process ) )
+                Goto<THEN>::apply( process );
+            else
+                Goto<ELSE>::apply( process );
+        }
+    };
+
+    template<class TRANSITION>
+    static void execute( DERIVED & process )
+    {
+        typename TRANSITION::action()( process );
+
+        Goto<typename TRANSITION::next>::apply( process );
+    }
+
+    template<class TRANSITION, class DUMMY = void>
+    struct HandlerOf
+    {
+        static Handler get()
+        {
+            return & execute<TRANSITION>;
+        }
+    };
+
+    template<class DUMMY>
+    struct HandlerOf<void, DUMMY>
+    {
+        static Handler get()
+        {
+            return nullptr;
+        }
+    };
+
+    template<class STATES, class SIGNALS>
+    struct Table;
+
+    // handler per state and signal, is built once per process type
+    template<class... STATE, class... SIGNAL>
+    struct Table<dsl::List<STATE...>, dsl::List<SIGNAL...>>
+    {
+        typedef std::array<Handler, sizeof...( SIGNAL )>  Row;
+
+        template<class S>
+        static Row make_row()
+        {
+            return Row {{ HandlerOf<typename dsl::Find<S, SIGNAL, typename DERIVED::transitions>::type>::get()... }};
+        }
+
+        static const std::array<Row, sizeof...( STATE )> & get()
+        {
+            static const std::array<Row, sizeof...( STATE )> table = {{ make_row<STATE>()... }};
+
+            return table;
+        }
+
+        // ev::Signal carries the name, so it is mapped to the column once per signal
+        static int find_signal( const std::string & name )
+        {
+            static const std::unordered_map<std::string,int> map_name_to_signal = make_map();
+
+            auto it = map_name_to_signal.find( name );
+
+            if( it == map_name_to_signal.end() )
+                return -1;
+
+            return it->second;
+        }
+
+        static std::unordered_map<std::string,int> make_map()
+        {
+            const char * names[] = { SIGNAL::name()... };
+
+            std::unordered_map<std::string,int> res;
+
+            for( unsigned i = 0; i < sizeof...( SIGNAL ); ++i )
+            {
+                res.insert( std::make_pair( std::string( names[i] ), int( i ) ) );
+            }
+
+            return res;
+        }
+    };
+
+    bool handle_signal( const std::string & name ) override
+    {
+        typedef Table<typename DERIVED::states, typename DERIVED::signals>  TableType;
+
+        auto signal = TableType::find_signal( name );
+
+        if( signal < 0 )
+            return false;
+
+        auto handler = TableType::get()[ state_ ][ signal ];
+
+        if( handler == nullptr )
+            return false;
+
+        handler( * static_cast<DERIVED*>( this ) );
+
+        return true;
+    }
+
+private:
+
+    unsigned        state_;
+};
+
+} // namespace fsm
+
+#endif // LIB_FSM__STATIC_PROCESS_H
@@ -133,7 +133,11 @@ std::string StrHelperExpr::to_string_ExpressionValue( const Expression & eexpr )
 {
     auto & a = dynamic_cast< const ExpressionValue&>( eexpr );
 
-    auto res = anyvalue::StrHelper::to_string_short( a.value );
+    Value value;
+
+    a.value.get( & value );
+
+    auto res = anyvalue::StrHelper::to_string_short( value );
 
     if( res.size() > 8 )
         return res.substr( 0, 8 ) + "...";
@@ -0,0 +1,72 @@
+/*
+
+FSM. Pool of interned strings.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11630 $ $Date:: 2019-06-02 #$ $Author: serge $
+
+#include "string_pool.h"        // self
+
+#include "utils/mutex_helper.h"     // MUTEX_SCOPE_LOCK
+
+namespace fsm {
+
+StringPool::StringPool()
+{
+}
+
+CompactValue StringPool::intern( const Value & v )
+{
+    if( v.type != data_type_e::STRING || v.arg_s.size() <= CompactValue::MAX_INLINE_SIZE )
+        return CompactValue( v );
+
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    auto it = map_string_to_value_.find( v.arg_s );
+
+    if( it != map_string_to_value_.end() )
+        return it->second;
+
+    CompactValue res( v );
+
+    map_string_to_value_.insert( std::make_pair( v.arg_s, res ) );
+
+    return res;
+}
+
+CompactValue StringPool::intern( const CompactValue & v )
+{
+    if( v.get_heap_size() == 0 )
+        return v;
+
+    Value res;
+
+    v.get( & res );
+
+    return intern( res );
+}
+
+std::size_t StringPool::get_size() const
+{
+    MUTEX_SCOPE_LOCK( mutex_ );
+
+    return map_string_to_value_.size();
+}
+
+} // namespace fsm
@@ -0,0 +1,63 @@
+/*
+
+FSM. Pool of interned strings.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11630 $ $Date:: 2019-06-02 #$ $Author: serge $
+
+#ifndef LIB_FSM__STRING_POOL_H
+#define LIB_FSM__STRING_POOL_H
+
+#include <string>               // std::string
+#include <unordered_map>        // std::unordered_map
+#include <mutex>                // std::mutex
+
+#include "compact_value.h"      // CompactValue
+
+namespace fsm {
+
+// immutable strings shared by all processes of a definition, an interned value is copied by incrementing a reference count
+class StringPool
+{
+public:
+    StringPool();
+
+    // non-string values and short strings are returned as is
+    CompactValue intern( const Value & v );
+    CompactValue intern( const CompactValue & v );
+
+    std::size_t get_size() const;
+
+private:
+    StringPool( const StringPool & )              = delete;
+    StringPool & operator=( const StringPool & )  = delete;
+
+private:
+    typedef std::unordered_map<std::string,CompactValue>    MapStringToValue;
+
+private:
+
+    mutable std::mutex          mutex_;
+
+    MapStringToValue            map_string_to_value_;
+};
+
+} // namespace fsm
+
+#endif // LIB_FSM__STRING_POOL_H
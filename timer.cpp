@@ -26,6 +26,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include <cassert>              // assert
 
 #include "utils/dummy_logger.h"     // dummy_log_debug
+#include "size_helper.h"            // SizeHelper
 
 namespace fsm {
 
@@ -47,4 +48,19 @@ scheduler::job_id_t Timer::get_job_id() const
     return sched_job_id_;
 }
 
+void Timer::set_fire_time( const std::chrono::steady_clock::time_point & t )
+{
+    fire_time_  = t;
+}
+
+const std::chrono::steady_clock::time_point & Timer::get_fire_time() const
+{
+    return fire_time_;
+}
+
+std::size_t Timer::get_memory_usage() const
+{
+    return sizeof( * this ) + SizeHelper::get_size( name_ );
+}
+
 } // namespace fsm
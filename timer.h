@@ -24,6 +24,8 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #ifndef LIB_FSM__TIMER_H
 #define LIB_FSM__TIMER_H
 
+#include <chrono>               // std::chrono::steady_clock
+
 #include "elements.h"           // Element
 #include "scheduler/job_id_t.h" // scheduler::job_id_t
 
@@ -37,6 +39,11 @@ public:
     void set_job_id( scheduler::job_id_t id );
     scheduler::job_id_t get_job_id() const;
 
+    void set_fire_time( const std::chrono::steady_clock::time_point & t );
+    const std::chrono::steady_clock::time_point & get_fire_time() const;
+
+    std::size_t get_memory_usage() const;
+
 private:
     Timer( const Timer & )              = delete;
     Timer & operator=( const Timer & )  = delete;
@@ -46,6 +53,7 @@ private:
     uint32_t                                log_id_;
 
     scheduler::job_id_t                     sched_job_id_;
+    std::chrono::steady_clock::time_point   fire_time_;
 };
 
 } // namespace fsm
@@ -0,0 +1,110 @@
+/*
+
+FSM. Operations on operands of statically known type.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11631 $ $Date:: 2019-06-03 #$ $Author: serge $
+
+#include "typed_operations.h"   // self
+
+namespace fsm {
+
+TypedOperations::UnaryOperation TypedOperations::find_unary_operation( unary_operation_type_e type, data_type_e operand_type )
+{
+    switch( operand_type )
+    {
+    case data_type_e::BOOL:
+        return type == unary_operation_type_e::NOT ? & unary<BoolArg, std::logical_not> : nullptr;
+
+    case data_type_e::INT:
+        return type == unary_operation_type_e::NEG ? & unary<IntArg, std::negate> : nullptr;
+
+    case data_type_e::DOUBLE:
+        return type == unary_operation_type_e::NEG ? & unary<DoubleArg, std::negate> : nullptr;
+
+    default:
+        return nullptr;
+    }
+}
+
+TypedOperations::BinaryOperation TypedOperations::find_binary_operation( binary_operation_type_e type, data_type_e operand_type )
+{
+    switch( operand_type )
+    {
+    case data_type_e::BOOL:
+        switch( type )
+        {
+        case binary_operation_type_e::AND:
+            return & binary<BoolArg, std::logical_and>;
+        case binary_operation_type_e::OR:
+            return & binary<BoolArg, std::logical_or>;
+        default:
+            return nullptr;
+        }
+
+    case data_type_e::INT:
+        switch( type )
+        {
+        case binary_operation_type_e::PLUS:
+            return & binary<IntArg, std::plus>;
+        case binary_operation_type_e::MINUS:
+            return & binary<IntArg, std::minus>;
+        case binary_operation_type_e::MUL:
+            return & binary<IntArg, std::multiplies>;
+        default:
+            // division is left to anyvalue, which handles division by zero
+            return nullptr;
+        }
+
+    case data_type_e::DOUBLE:
+        switch( type )
+        {
+        case binary_operation_type_e::PLUS:
+            return & binary<DoubleArg, std::plus>;
+        case binary_operation_type_e::MINUS:
+            return & binary<DoubleArg, std::minus>;
+        case binary_operation_type_e::MUL:
+            return & binary<DoubleArg, std::multiplies>;
+        case binary_operation_type_e::DIV:
+            return & binary<DoubleArg, std::divides>;
+        default:
+            return nullptr;
+        }
+
+    default:
+        return nullptr;
+    }
+}
+
+TypedOperations::Comparison TypedOperations::find_comparison( comparison_type_e type, data_type_e operand_type )
+{
+    switch( operand_type )
+    {
+    case data_type_e::BOOL:
+        return find_comparison<BoolArg>( type );
+    case data_type_e::INT:
+        return find_comparison<IntArg>( type );
+    case data_type_e::DOUBLE:
+        return find_comparison<DoubleArg>( type );
+    default:
+        return nullptr;
+    }
+}
+
+} // namespace fsm
@@ -0,0 +1,140 @@
+/*
+
+FSM. Operations on operands of statically known type.
+
+Copyright (C) 2019 Sergey Kolevatov
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// $Revision: 11631 $ $Date:: 2019-06-03 #$ $Author: serge $
+
+#ifndef LIB_FSM__TYPED_OPERATIONS_H
+#define LIB_FSM__TYPED_OPERATIONS_H
+
+#include <functional>           // std::plus
+
+#include "elements.h"           // Value
+
+namespace fsm {
+
+// monomorphic bool/int/double operations, are selected by the static operand type at finalize and are not checked at runtime,
+// i.e. the operands must have that type, nullptr - the operation or the operand type is not covered, then anyvalue has to be used
+class TypedOperations
+{
+public:
+
+    typedef void (*UnaryOperation)( Value * res, const Value & op );
+    typedef void (*BinaryOperation)( Value * res, const Value & lhs, const Value & rhs );
+    typedef bool (*Comparison)( const Value & lhs, const Value & rhs );
+
+    static UnaryOperation find_unary_operation( unary_operation_type_e type, data_type_e operand_type );
+    static BinaryOperation find_binary_operation( binary_operation_type_e type, data_type_e operand_type );
+    static Comparison find_comparison( comparison_type_e type, data_type_e operand_type );
+
+private:
+
+    struct BoolArg
+    {
+        typedef bool type;
+
+        static type get( const Value & v )
+        {
+            return v.arg_b;
+        }
+
+        static void set( Value * v, type x )
+        {
+            v->type     = data_type_e::BOOL;
+            v->arg_b    = x;
+        }
+    };
+
+    struct IntArg
+    {
+        typedef decltype( Value::arg_i ) type;
+
+        static type get( const Value & v )
+        {
+            return v.arg_i;
+        }
+
+        static void set( Value * v, type x )
+        {
+            v->type     = data_type_e::INT;
+            v->arg_i    = x;
+        }
+    };
+
+    struct DoubleArg
+    {
+        typedef decltype( Value::arg_d ) type;
+
+        static type get( const Value & v )
+        {
+            return v.arg_d;
+        }
+
+        static void set( Value * v, type x )
+        {
+            v->type     = data_type_e::DOUBLE;
+            v->arg_d    = x;
+        }
+    };
+
+    template<class ARG, template<class> class OP>
+    static void unary( Value * res, const Value & op )
+    {
+        ARG::set( res, OP<typename ARG::type>()( ARG::get( op ) ) );
+    }
+
+    template<class ARG, template<class> class OP>
+    static void binary( Value * res, const Value & lhs, const Value & rhs )
+    {
+        ARG::set( res, OP<typename ARG::type>()( ARG::get( lhs ), ARG::get( rhs ) ) );
+    }
+
+    template<class ARG, template<class> class OP>
+    static bool compare( const Value & lhs, const Value & rhs )
+    {
+        return OP<typename ARG::type>()( ARG::get( lhs ), ARG::get( rhs ) );
+    }
+
+    template<class ARG>
+    static Comparison find_comparison( comparison_type_e type )
+    {
+        switch( type )
+        {
+        case comparison_type_e::EQ:
+            return & compare<ARG, std::equal_to>;
+        case comparison_type_e::NEQ:
+            return & compare<ARG, std::not_equal_to>;
+        case comparison_type_e::LT:
+            return & compare<ARG, std::less>;
+        case comparison_type_e::LE:
+            return & compare<ARG, std::less_equal>;
+        case comparison_type_e::GT:
+            return & compare<ARG, std::greater>;
+        case comparison_type_e::GE:
+            return & compare<ARG, std::greater_equal>;
+        default:
+            return nullptr;
+        }
+    }
+};
+
+} // namespace fsm
+
+#endif // LIB_FSM__TYPED_OPERATIONS_H
@@ -26,6 +26,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include <cassert>              // assert
 
 #include "utils/dummy_logger.h"     // dummy_log_debug
+#include "size_helper.h"            // SizeHelper
 
 namespace fsm {
 
@@ -33,24 +34,51 @@ Variable::Variable( uint32_t log_id, element_id_t id, const std::string & name,
         NamedElement( id, name ),
         log_id_( log_id ),
         type_( type ),
-        is_inited_( false )
+        is_inited_( false ),
+        is_changed_( false )
 {
     assert( id );
 
-    value_.type = type;
+    Value v;
+
+    v.type = type;
+
+    value_.set( v );
+
+    initial_value_  = value_;
 }
 
 Variable::Variable( uint32_t log_id, element_id_t id, const std::string & name, data_type_e type, const Value & value ):
         NamedElement( id, name ),
         log_id_( log_id ),
         type_( type ),
-        is_inited_( true )
+        is_inited_( true ),
+        is_changed_( false )
 {
     assert( id );
 
-    value_.type = type;
+    Value v;
+
+    v.type = type;
+
+    anyvalue::assign( & v, value );
 
-    anyvalue::assign( & value_, value );
+    value_.set( v );
+
+    initial_value_  = value_;
+}
+
+Variable::Variable( uint32_t log_id, element_id_t id, const std::string & name, data_type_e type, const CompactValue & value ):
+        NamedElement( id, name ),
+        log_id_( log_id ),
+        type_( type ),
+        is_inited_( true ),
+        is_changed_( false ),
+        value_( value ),
+        initial_value_( value )
+{
+    assert( id );
+    assert( value.get_type() == type );
 }
 
 data_type_e Variable::get_type() const
@@ -63,18 +91,76 @@ bool Variable::is_inited() const
     return is_inited_;
 }
 
-const Value & Variable::get() const
+void Variable::get( Value * value ) const
+{
+    value_.get( value );
+}
+
+const CompactValue & Variable::get_compact_value() const
 {
     return value_;
 }
 
 void Variable::set( const Value & v )
 {
-    value_  = v;
+    value_.set( v );
+    is_changed_ = true;
 }
 
 void Variable::assign( const Value & v )
 {
-    anyvalue::assign( & value_, v );
+    if( value_.assign( v ) == false )
+    {
+        // conversion to the type of the variable
+        Value res;
+
+        value_.get( & res );
+
+        anyvalue::assign( & res, v );
+
+        value_.set( res );
+    }
+
+    is_changed_ = true;
+}
+
+void Variable::assign( const CompactValue & v )
+{
+    if( v.get_type() != type_ )
+    {
+        Value res;
+
+        v.get( & res );
+
+        assign( res );
+
+        return;
+    }
+
+    value_      = v;
+    is_changed_ = true;
+}
+
+bool Variable::is_changed() const
+{
+    return is_changed_;
 }
+
+void Variable::clear_changed()
+{
+    is_changed_ = false;
+}
+
+void Variable::reset()
+{
+    // long strings are shared with the initial value, not copied
+    value_      = initial_value_;
+    is_changed_ = false;
+}
+
+std::size_t Variable::get_memory_usage() const
+{
+    return sizeof( * this ) + SizeHelper::get_size( name_ ) + value_.get_heap_size() + initial_value_.get_heap_size();
+}
+
 } // namespace fsm
@@ -25,6 +25,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #define LIB_FSM__VARIABLE_H
 
 #include "elements.h"      // Value
+#include "compact_value.h"  // CompactValue
 
 namespace fsm {
 
@@ -33,12 +34,23 @@ class Variable: public NamedElement
 public:
     Variable( uint32_t log_id, element_id_t id, const std::string & name, data_type_e type );
     Variable( uint32_t log_id, element_id_t id, const std::string & name, data_type_e type, const Value & value );
+    Variable( uint32_t log_id, element_id_t id, const std::string & name, data_type_e type, const CompactValue & value );
 
     data_type_e get_type() const;
     bool is_inited() const;
-    const Value & get() const;
+    void get( Value * value ) const;
+    const CompactValue & get_compact_value() const;
     void set( const Value & v );
     void assign( const Value & v );
+    // a long string shares the buffer of the source
+    void assign( const CompactValue & v );
+
+    bool is_changed() const;
+    void clear_changed();
+
+    void reset();
+
+    std::size_t get_memory_usage() const;
 
 private:
     Variable( const Variable & )              = delete;
@@ -49,7 +61,9 @@ protected:
     uint32_t                                log_id_;
     data_type_e                             type_;
     bool                                    is_inited_;
-    Value                                   value_;
+    bool                                    is_changed_;
+    CompactValue                            value_;
+    CompactValue                            initial_value_;
 };
 
 } // namespace fsm